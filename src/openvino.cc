@@ -25,21 +25,38 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stdint.h>
+#include <string.h>
 
 #include <openvino/openvino.hpp>
 #include <openvino/pass/serialize.hpp>
 #include <openvino/runtime/tensor.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <future>
 #include <inference_engine.hpp>
+#include <memory>
 #include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 #include <string>
+#include "openvino_metrics.h"
+#include "openvino_perf_counters.h"
+#include "openvino_trace.h"
 #include "openvino_utils.h"
 #include "triton/backend/backend_input_collector.h"
 #include "triton/backend/backend_memory.h"
 #include "triton/backend/backend_model.h"
 #include "triton/backend/backend_model_instance.h"
-#include "triton/backend/backend_output_responder.h"
 
 //
 // OpenVINO Backend that implements the TRITONBACKEND API.
@@ -56,8 +73,57 @@ IsNumber(const std::string& str)
            return !std::isdigit(c);
          }) == str.end();
 }
+
+// Parses 'str' as a non-negative number into 'value', returning false if
+// it isn't one or doesn't fit.
+bool
+ParseSize(const std::string& str, size_t* value)
+{
+  if (str.empty() || !IsNumber(str)) {
+    return false;
+  }
+  unsigned long long number;
+  try {
+    number = std::stoull(str);
+  }
+  catch (const std::out_of_range&) {
+    return false;
+  }
+  if (number > SIZE_MAX) {
+    return false;
+  }
+  *value = number;
+  return true;
+}
 }  // namespace
 
+//
+// BackendState
+//
+// State shared by all the models using this backend. An object of this
+// class is created and associated with the TRITONBACKEND_Backend. The
+// OpenVINO core holds the plugins and their thread pools, which are then
+// created once for all the models instead of once per model.
+//
+struct BackendState {
+  ov::Core core;
+  // The CPU extensions added to 'core', each of which is added once for
+  // all the models using it.
+  std::mutex extensions_mu;
+  std::set<std::string> extension_paths;
+  // The metric families of the backend, null if Triton doesn't collect
+  // custom metrics.
+  std::unique_ptr<BackendMetrics> metrics;
+  // The hardware counters of the process, opened by the first model that
+  // reads them, the window the inferences of all the instances count
+  // the process in, and the metrics of those counts, null if Triton
+  // doesn't collect custom metrics.
+  std::mutex perf_counters_mu;
+  std::unique_ptr<PerfCounters> perf_counters;
+  std::unique_ptr<PerfWindow> perf_infer_window;
+  std::unique_ptr<ProcessPerfMetrics> perf_metrics;
+};
+
 //
 // ModelState
 //
@@ -69,7 +135,7 @@ class ModelState : public BackendModel {
  public:
   static TRITONSERVER_Error* Create(
       TRITONBACKEND_Model* triton_model, ModelState** state);
-  virtual ~ModelState() = default;
+  virtual ~ModelState();
 
   TRITONSERVER_Error* PrintModelConfig();
   TRITONSERVER_Error* ParseParameters();
@@ -79,15 +145,21 @@ class ModelState : public BackendModel {
   TRITONSERVER_Error* ParseBoolParameter(
       const std::string& mkey, triton::common::TritonJson::Value& params,
       bool* setting);
+  // Sets 'setting' to the value of the parameter if it is present, which
+  // must then be a non-negative number.
+  TRITONSERVER_Error* ParseNumberParameter(
+      const std::string& mkey, triton::common::TritonJson::Value& params,
+      size_t* setting);
   TRITONSERVER_Error* ParseParameter(
       const std::string& mkey, triton::common::TritonJson::Value& params,
       //del by zhaohb
       //std::map<std::string, std::string>* device_config);
       std::map<std::string, ov::Any>* device_config);
+  TRITONSERVER_Error* ParseBatchBuckets(
+      triton::common::TritonJson::Value& params);
   TRITONSERVER_Error* ParseParameterHelper(
       const std::string& mkey, std::string* ov_key, std::string* value);
 
-  TRITONSERVER_Error* ConfigureInferenceEngine();
 
   // Reads the Intermediate Representation(IR) model using `artifact_name`
   // as the name for the model file/directory. Return in `model_path` the
@@ -96,23 +168,102 @@ class ModelState : public BackendModel {
       const std::string& artifact_name, std::string* model_path);
 
   TRITONSERVER_Error* ValidateConfigureNetwork();
-  //del by zhaohb
-  //TRITONSERVER_Error* ValidateInputs(const size_t expected_input_cnt);
-  //TRITONSERVER_Error* ValidateOutputs();
+  // Reshapes the inputs of the network whose dims in the model
+  // configuration have -1 dimensions so that these dimensions are
+  // dynamic, and with 'RESHAPE_IO_LAYERS' all the inputs to the dims of
+  // the model configuration.
+  TRITONSERVER_Error* ReshapeVariableDims();
+  // Reshapes 'network' so that the batch dimension of its inputs is
+  // 'batch', which may be dynamic.
+  TRITONSERVER_Error* ReshapeBatch(
+      const std::shared_ptr<ov::Model>& network, const ov::Dimension& batch);
+  // Checks that the inputs and outputs of the model configuration are
+  // those of the network, with matching dimensions.
+  TRITONSERVER_Error* ValidateInputs();
+  TRITONSERVER_Error* ValidateOutputs();
 
   // Loads the configured model on the target device (currently only CPU) is
-  // supported.
+  // supported. With 'numa_node' other than -1 the network is restricted
+  // to the CPUs of that NUMA node.
   TRITONSERVER_Error* LoadNetwork(
-      const std::string& device,
+      const std::string& device, const int numa_node,
       const std::map<std::string, ov::AnyMap> network_config);
-
-  // Creates an infer request object on the specified device.
+  // Returns the key of the network loaded on 'device' for 'numa_node', by
+  // which the methods below find it.
+  static std::string NetworkKey(const std::string& device, const int numa_node);
+
+  // Returns in 'numa_node' the NUMA node to place the next model instance
+  // on, -1 if the instances are not placed.
+  void AssignNumaNode(int* numa_node);
+  const std::vector<int>& NumaNodeCpus(const int numa_node)
+  {
+    return numa_nodes_[numa_node];
+  }
+  // Runs a few inferences of the network loaded for 'numa_node' and
+  // warns if threads outside the CPUs of the node took part in them.
+  TRITONSERVER_Error* VerifyNumaThreads(
+      const std::string& network_key, const int numa_node);
+
+  // Returns in 'count' the number of infer requests each model instance
+  // should create on the specified network.
+  TRITONSERVER_Error* InferRequestCount(
+      const std::string& network_key, size_t* count);
+  // Returns in 'count' the number of instances of the model across its
+  // instance groups.
+  TRITONSERVER_Error* InstanceCount(size_t* count);
+  // Returns in 'size' the number of rows of the micro-batches the batches
+  // are split into on the specified network, and in 'count' the number of
+  // micro-batches an execution can run at once. Both are 0 if the batches
+  // are not split.
+  TRITONSERVER_Error* MicroBatchLayout(
+      const std::string& network_key, size_t* size, size_t* count);
+  // Logs the streams and the optimal number of infer requests the network
+  // was compiled with, and the instance_group count these call for.
+  TRITONSERVER_Error* LogExecutionLayout(
+      const std::string& network_key, const ov::AnyMap& properties);
+
+  // Creates an infer request object on the specified network, for the
+  // network loaded for 'batch_bucket' if batch buckets are used.
   TRITONSERVER_Error* CreateInferRequest(
       //changed by zhaohb for support ov 2022.1
-      const std::string& device, ov::InferRequest* infer_request);
+      const std::string& network_key, const size_t batch_bucket,
+      ov::InferRequest* infer_request);
       //const std::string& device, InferenceEngine::InferRequest* infer_request);
 
-  TRITONSERVER_Error* SetNameNodeMap(std::map<std::string, ov::Output<const ov::Node> > * name_node_map_);
+  // Compiles 'network' for the specified device, or imports it from the
+  // model cache if it was compiled before with the same model files,
+  // OpenVINO version, device and configuration. 'variant' distinguishes
+  // the networks derived from the same model files.
+  TRITONSERVER_Error* CompileModel(
+      const std::shared_ptr<ov::Model>& network, const std::string& device,
+      const ov::AnyMap& properties, const std::string& variant,
+      ov::CompiledModel* compiled);
+  TRITONSERVER_Error* ImportModel(
+      const std::string& cache_path, const std::string& device,
+      const ov::AnyMap& properties, ov::CompiledModel* compiled);
+  // Publishes 'compiled' to the model cache as 'cache_path'.
+  TRITONSERVER_Error* ExportModel(
+      ov::CompiledModel& compiled, const std::string& cache_path);
+  // Returns in 'key' the cache key of 'variant' of the network compiled
+  // for the specified device with 'properties'.
+  TRITONSERVER_Error* ModelCacheKey(
+      const std::string& device, const ov::AnyMap& properties,
+      const std::string& variant, uint64_t* key);
+
+  // Returns in 'compiled' the specified network loaded for the batch
+  // bucket 'batch_bucket', 0 if batch buckets are not used.
+  TRITONSERVER_Error* CompiledNetwork(
+      const std::string& network_key, const size_t batch_bucket,
+      ov::CompiledModel** compiled);
+  // Returns in 'compiled' the specified network pruned down to the
+  // outputs among 'output_names' whose bit is set in 'output_mask', or
+  // nullptr if it is not compiled yet. The pruned network is compiled in
+  // the background on first use, in place of the least recently used one
+  // when there are already 'MAX_PRUNED_VARIANTS' of them.
+  TRITONSERVER_Error* PrunedNetwork(
+      const std::string& network_key, const uint64_t output_mask,
+      const std::vector<const char*>& output_names,
+      std::shared_ptr<ov::CompiledModel>* compiled);
 
   //delete by zhaohb, can find api in 2022.1
   //TRITONSERVER_Error* GetInputsInfo(
@@ -120,9 +271,9 @@ class ModelState : public BackendModel {
 
   // Whether or not the network is read successfully
   bool NetworkNotRead();
-  // Whether or not a executable network is loaded on
-  // the specified device.
-  bool NetworkNotLoaded(const std::string device_);
+  // Whether or not a executable network is loaded as the specified
+  // network.
+  bool NetworkNotLoaded(const std::string network_key);
 
   //change by zhaohb for support ov 2022.1
   std::shared_ptr<ov::Model>* Network() { return &network_; }
@@ -130,14 +281,50 @@ class ModelState : public BackendModel {
 
   bool SkipDynamicBatchSize() { return skip_dynamic_batchsize_; }
   bool EnableBatchPadding() { return enable_padding_; }
-  std::map<std::string, ov::Output<const ov::Node> > name_node_map;
+  bool EnableZeroCopyInput() { return enable_zero_copy_input_; }
+  bool EnableZeroCopyOutput() { return enable_zero_copy_output_; }
+  bool EnableAsyncExecution() { return enable_async_execution_; }
+  bool EnableOutputPruning() { return enable_output_pruning_; }
+  size_t MaxPrunedVariants() { return max_pruned_variants_; }
+  // The executions whose per-layer profile is sampled, one in every
+  // 'ProfilingInterval()' or none if 0, and how the profiles are reported.
+  size_t ProfilingInterval() { return profiling_interval_; }
+  size_t ProfilingTopLayers() { return profiling_top_layers_; }
+  size_t ProfilingReportSec() { return profiling_report_sec_; }
+  const std::string& ProfilingOutput() { return profiling_output_; }
+  // The trace the executions are captured to, null if not captured, and
+  // which of them are captured.
+  TraceWriter* CaptureTrace() { return trace_writer_.get(); }
+  size_t CaptureInterval() { return capture_interval_; }
+  size_t CaptureLatencyThresholdUs() { return capture_threshold_us_; }
+  bool CaptureInputs() { return capture_inputs_; }
+  // The executions whose hardware counters are read, one in every
+  // 'PerfCountersInterval()' or none if 0, how often the counts are
+  // logged, the window of the process the inferences are counted in and
+  // the metrics of its counts, null if Triton doesn't collect them.
+  size_t PerfCountersInterval() { return perf_interval_; }
+  size_t PerfCountersReportSec() { return perf_report_sec_; }
+  PerfWindow* ProcessPerfWindow()
+  {
+    return backend_state_->perf_infer_window.get();
+  }
+  ProcessPerfMetrics* ProcessMetrics()
+  {
+    return backend_state_->perf_metrics.get();
+  }
+  bool EnableLatencyParameters() { return enable_latency_parameters_; }
+  const std::vector<size_t>& BatchBuckets() { return batch_buckets_; }
+  bool HasVariableDims() { return has_variable_dims_; }
+  // The metric families of the backend, null if metrics are disabled.
+  BackendMetrics* Metrics() { return backend_state_->metrics.get(); }
 
  private:
   ModelState(TRITONBACKEND_Model* triton_model);
   TRITONSERVER_Error* AutoCompleteConfig();
 
-  //add by zhaohb for ov 2022.1
-  ov::Core core;
+  // The state of the backend holding the OpenVINO core shared by all the
+  // models.
+  BackendState* backend_state_;
   // Shared resources among the multiple instances.
   //change by zhaohb for ov 2022.1
   //InferenceEngine::Core inference_engine_;
@@ -148,6 +335,10 @@ class ModelState : public BackendModel {
 
   //changed by zhaohb for support 2022.1
   std::map<std::string, ov::CompiledModel> executable_network_;
+  // The networks loaded with a static batch for each batch bucket, the
+  // largest of which is also the executable network of the device.
+  std::map<std::string, std::map<size_t, ov::CompiledModel>>
+      batch_bucket_network_;
   //std::map<std::string, InferenceEngine::ExecutableNetwork> executable_network_;
   // Maps device to their respective parameters
 
@@ -159,6 +350,85 @@ class ModelState : public BackendModel {
   bool skip_dynamic_batchsize_;
   bool enable_padding_;
   bool reshape_io_layers_;
+  bool enable_zero_copy_input_;
+  bool enable_zero_copy_output_;
+  bool enable_async_execution_;
+  // The number of infer requests per model instance, 0 to use the optimal
+  // number reported by the device.
+  size_t infer_request_count_;
+  // The sorted batch sizes to load the network with, empty if the network
+  // is loaded once.
+  std::vector<size_t> batch_buckets_;
+  // The number of rows of the micro-batches, 0 if the batches are not
+  // split, unless chosen after the optimal number of infer requests.
+  size_t micro_batch_size_;
+  bool micro_batch_auto_;
+  // Whether some inputs have dimensions other than the batch that vary
+  // from one request to another.
+  bool has_variable_dims_;
+
+  // The directory of the model cache, empty if the compiled networks are
+  // not cached.
+  std::string cache_dir_;
+  // The hash of the files of the model, read when the model cache is used.
+  uint64_t model_hash_;
+  // The hits and misses of the model cache, null if metrics are disabled.
+  std::unique_ptr<ModelMetrics> metrics_;
+
+  // The sampling of the per-layer profile of the executions.
+  size_t profiling_interval_;
+  size_t profiling_top_layers_;
+  size_t profiling_report_sec_;
+  std::string profiling_output_;
+
+  // The capture of the executions to a trace.
+  std::unique_ptr<TraceWriter> trace_writer_;
+  size_t capture_interval_;
+  size_t capture_threshold_us_;
+  bool capture_inputs_;
+
+  // The sampling of the hardware counters of the executions.
+  size_t perf_interval_;
+  size_t perf_report_sec_;
+
+  // Whether the responses carry the durations of the stages of their
+  // execution.
+  bool enable_latency_parameters_;
+
+  // Whether the model instances are spread over the NUMA nodes of the
+  // host, with the CPUs of each node by node id, and the number of
+  // instances placed so far.
+  bool enable_numa_placement_;
+  std::map<int, std::vector<int>> numa_nodes_;
+  size_t numa_instance_count_;
+
+  // The device, NUMA node and properties each network was compiled with,
+  // by network key, to compile its pruned variants alike.
+  struct NetworkTarget {
+    std::string device;
+    int numa_node;
+    ov::AnyMap properties;
+  };
+  std::map<std::string, NetworkTarget> network_targets_;
+  // Compiles the network of 'target' pruned to 'kept_outputs', whose bits
+  // are set in 'output_mask'.
+  TRITONSERVER_Error* CompilePrunedModel(
+      const NetworkTarget& target, const uint64_t output_mask,
+      const std::vector<std::string>& kept_outputs,
+      ov::CompiledModel* compiled);
+
+  // The networks pruned to the outputs requested together, by network key
+  // and output mask, each resolving to nullptr if it failed to compile,
+  // along with the use they were last returned for.
+  struct PrunedVariant {
+    std::shared_future<std::shared_ptr<ov::CompiledModel>> compiled;
+    uint64_t last_use;
+  };
+  bool enable_output_pruning_;
+  size_t max_pruned_variants_;
+  std::mutex pruned_mu_;
+  std::map<std::pair<std::string, uint64_t>, PrunedVariant> pruned_variants_;
+  uint64_t pruned_use_count_;
 };
 
 TRITONSERVER_Error*
@@ -206,10 +476,43 @@ ModelState::Create(TRITONBACKEND_Model* triton_model, ModelState** state)
 }
 
 ModelState::ModelState(TRITONBACKEND_Model* triton_model)
-    : BackendModel(triton_model), network_read_(false),
-      skip_dynamic_batchsize_(false), enable_padding_(false),
-      reshape_io_layers_(false)
+    : BackendModel(triton_model), backend_state_(nullptr),
+      network_read_(false), skip_dynamic_batchsize_(false),
+      enable_padding_(false), reshape_io_layers_(false),
+      enable_zero_copy_input_(false), enable_zero_copy_output_(false),
+      enable_async_execution_(false), infer_request_count_(1),
+      micro_batch_size_(0), micro_batch_auto_(false),
+      has_variable_dims_(false), model_hash_(0), profiling_interval_(0),
+      profiling_top_layers_(10), profiling_report_sec_(60),
+      capture_interval_(0), capture_threshold_us_(0), capture_inputs_(false),
+      perf_interval_(0), perf_report_sec_(60),
+      enable_latency_parameters_(false),
+      enable_numa_placement_(false),
+      numa_instance_count_(0),
+      enable_output_pruning_(false), max_pruned_variants_(4),
+      pruned_use_count_(0)
+{
+  TRITONBACKEND_Backend* backend;
+  THROW_IF_BACKEND_MODEL_ERROR(
+      TRITONBACKEND_ModelBackend(triton_model, &backend));
+  void* vstate;
+  THROW_IF_BACKEND_MODEL_ERROR(TRITONBACKEND_BackendState(backend, &vstate));
+  backend_state_ = reinterpret_cast<BackendState*>(vstate);
+
+  if (Metrics() != nullptr) {
+    LOG_IF_ERROR(
+        ModelMetrics::Create(Metrics(), Name(), Version(), &metrics_),
+        "failed to create the metrics of the model");
+  }
+}
+
+ModelState::~ModelState()
 {
+  // Wait for the pruned networks still compiling, which use the network.
+  std::lock_guard<std::mutex> lock(pruned_mu_);
+  for (auto& item : pruned_variants_) {
+    item.second.compiled.wait();
+  }
 }
 
 TRITONSERVER_Error*
@@ -255,12 +558,29 @@ ModelState::ReadNetwork(
   }
 
   RETURN_IF_OPENVINO_ASSIGN_ERROR(
-      network_, core.read_model(*model_path), "reading network");
+      network_, backend_state_->core.read_model(*model_path),
+      "reading network");
       //del by zhaohb
       //network_, inference_engine_.ReadNetwork(*model_path), "reading network");
 
   network_read_ = true;
 
+  // The cache entries are keyed by the content of the model files, the
+  // weights being next to the IR.
+  if (!cache_dir_.empty()) {
+    model_hash_ = kFnvOffsetBasis;
+    RETURN_IF_ERROR(HashFile(*model_path, &model_hash_));
+    const size_t ext = model_path->rfind(".xml");
+    if (ext != std::string::npos) {
+      const std::string weights_path = model_path->substr(0, ext) + ".bin";
+      bool exists;
+      RETURN_IF_ERROR(FileExists(weights_path, &exists));
+      if (exists) {
+        RETURN_IF_ERROR(HashFile(weights_path, &model_hash_));
+      }
+    }
+  }
+
   // Mark up batch in the layout of the input(s) and reset batch to the new value
   //network_->get_parameters()[0]->set_layout("N...");
   //ov::set_batch(network_, new_batch);
@@ -281,8 +601,234 @@ ModelState::ParseParameters()
         ParseBoolParameter("ENABLE_BATCH_PADDING", params, &enable_padding_));
     RETURN_IF_ERROR(
         ParseBoolParameter("RESHAPE_IO_LAYERS", params, &reshape_io_layers_));
+    RETURN_IF_ERROR(ParseBoolParameter(
+        "ENABLE_ZERO_COPY_INPUT", params, &enable_zero_copy_input_));
+    RETURN_IF_ERROR(ParseBoolParameter(
+        "ENABLE_ZERO_COPY_OUTPUT", params, &enable_zero_copy_output_));
+    RETURN_IF_ERROR(ParseBoolParameter(
+        "ENABLE_ASYNC_EXECUTION", params, &enable_async_execution_));
+
+    std::string value;
+    ReadParameter(params, "NUM_INFER_REQUESTS", &value);
+    std::transform(
+        value.begin(), value.end(), value.begin(),
+        [](unsigned char c) { return std::tolower(c); });
+    if (value.compare("auto") == 0) {
+      infer_request_count_ = 0;
+    } else if (!value.empty()) {
+      if (!ParseSize(value, &infer_request_count_) ||
+          (infer_request_count_ == 0)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            (std::string("expected the parameter 'NUM_INFER_REQUESTS' to be "
+                         "a positive number or AUTO, got ") +
+             value)
+                .c_str());
+      }
+    } else {
+      // With a performance hint the pool is sized after the number of
+      // infer requests the device finds optimal for the hint.
+      std::string hint;
+      ReadParameter(params, "PERFORMANCE_HINT", &hint);
+      if (!hint.empty()) {
+        infer_request_count_ = 0;
+      }
+    }
+
+    RETURN_IF_ERROR(ParseBatchBuckets(params));
+
+    value.clear();
+    ReadParameter(params, "MICRO_BATCH_SIZE", &value);
+    std::transform(
+        value.begin(), value.end(), value.begin(),
+        [](unsigned char c) { return std::tolower(c); });
+    if (!value.empty()) {
+      if (value.compare("auto") == 0) {
+        micro_batch_auto_ = true;
+      } else if (
+          !ParseSize(value, &micro_batch_size_) || (micro_batch_size_ == 0)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            (std::string("expected the parameter 'MICRO_BATCH_SIZE' to be "
+                         "a positive number or AUTO, got ") +
+             value)
+                .c_str());
+      }
+      // The micro-batches run with their own batch on the same network.
+      RETURN_ERROR_IF_TRUE(
+          (MaxBatchSize() == 0) || skip_dynamic_batchsize_ ||
+              !batch_buckets_.empty(),
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string("the parameter 'MICRO_BATCH_SIZE' requires the model '") +
+              Name() +
+              "' to have a dynamic batch, without 'BATCH_BUCKETS' or "
+              "'SKIP_OV_DYNAMIC_BATCHSIZE'");
+    }
+
+    RETURN_IF_ERROR(ParseBoolParameter(
+        "ENABLE_OUTPUT_PRUNING", params, &enable_output_pruning_));
+    value.clear();
+    ReadParameter(params, "MAX_PRUNED_VARIANTS", &value);
+    if (!value.empty()) {
+      if (!ParseSize(value, &max_pruned_variants_) ||
+          (max_pruned_variants_ == 0)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            (std::string("expected the parameter 'MAX_PRUNED_VARIANTS' to be "
+                         "a positive number, got ") +
+             value)
+                .c_str());
+      }
+    }
+    // The pruned networks are compiled from the network as loaded, and
+    // the micro-batches run on the whole network.
+    RETURN_ERROR_IF_TRUE(
+        enable_output_pruning_ &&
+            (!batch_buckets_.empty() || (micro_batch_size_ > 0) ||
+             micro_batch_auto_),
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string("the parameter 'ENABLE_OUTPUT_PRUNING' of model '") +
+            Name() +
+            "' can't be set along with 'BATCH_BUCKETS' or 'MICRO_BATCH_SIZE'");
+
+    ReadParameter(params, "MODEL_CACHE_DIR", &cache_dir_);
+
+    RETURN_IF_ERROR(ParseNumberParameter(
+        "PROFILING_INTERVAL", params, &profiling_interval_));
+    RETURN_IF_ERROR(ParseNumberParameter(
+        "PROFILING_TOP_LAYERS", params, &profiling_top_layers_));
+    RETURN_IF_ERROR(ParseNumberParameter(
+        "PROFILING_REPORT_INTERVAL", params, &profiling_report_sec_));
+    ReadParameter(params, "PROFILING_OUTPUT", &profiling_output_);
+
+    std::string capture_path;
+    ReadParameter(params, "CAPTURE_PATH", &capture_path);
+    if (!capture_path.empty()) {
+      RETURN_IF_ERROR(ParseNumberParameter(
+          "CAPTURE_INTERVAL", params, &capture_interval_));
+      RETURN_IF_ERROR(ParseNumberParameter(
+          "CAPTURE_LATENCY_THRESHOLD_US", params, &capture_threshold_us_));
+      RETURN_IF_ERROR(
+          ParseBoolParameter("CAPTURE_INPUTS", params, &capture_inputs_));
+      // Without a criterion every execution is captured.
+      if ((capture_interval_ == 0) && (capture_threshold_us_ == 0)) {
+        capture_interval_ = 1;
+      }
+      RETURN_IF_ERROR(
+          TraceWriter::Create(capture_path, Name(), Version(), &trace_writer_));
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_INFO,
+          (std::string("capturing the executions of '") + Name() + "' to '" +
+           capture_path + "'")
+              .c_str());
+    }
+
+    bool perf_counters = false;
+    RETURN_IF_ERROR(
+        ParseBoolParameter("PERF_COUNTERS", params, &perf_counters));
+    if (perf_counters) {
+#ifndef __linux__
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          (std::string("the parameter 'PERF_COUNTERS' of model '") + Name() +
+           "' is only supported on Linux")
+              .c_str());
+#endif  // !__linux__
+      // The counters of the thread are read on the thread executing the
+      // instance, which asynchronous executions leave before they end.
+      RETURN_ERROR_IF_TRUE(
+          enable_async_execution_, TRITONSERVER_ERROR_INVALID_ARG,
+          std::string("the parameter 'PERF_COUNTERS' of model '") + Name() +
+              "' can't be set along with 'ENABLE_ASYNC_EXECUTION'");
+      perf_interval_ = 1;
+      RETURN_IF_ERROR(ParseNumberParameter(
+          "PERF_COUNTERS_INTERVAL", params, &perf_interval_));
+      RETURN_IF_ERROR(ParseNumberParameter(
+          "PERF_COUNTERS_REPORT_INTERVAL", params, &perf_report_sec_));
+      std::lock_guard<std::mutex> lock(backend_state_->perf_counters_mu);
+      if (backend_state_->perf_counters == nullptr) {
+        RETURN_IF_ERROR(
+            PerfCounters::CreateForProcess(&backend_state_->perf_counters));
+        backend_state_->perf_infer_window.reset(
+            new PerfWindow(backend_state_->perf_counters.get()));
+        if (backend_state_->metrics != nullptr) {
+          LOG_IF_ERROR(
+              ProcessPerfMetrics::Create(
+                  backend_state_->metrics.get(),
+                  &backend_state_->perf_metrics),
+              "failed to create the metrics of the hardware counters");
+        }
+      }
+    }
+
+    RETURN_IF_ERROR(ParseBoolParameter(
+        "ENABLE_LATENCY_PARAMETERS", params, &enable_latency_parameters_));
+
+    RETURN_IF_ERROR(ParseBoolParameter(
+        "ENABLE_NUMA_PLACEMENT", params, &enable_numa_placement_));
+    if (enable_numa_placement_) {
+      RETURN_IF_ERROR(ReadNumaNodes(&numa_nodes_));
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_INFO,
+          (std::string("found ") + std::to_string(numa_nodes_.size()) +
+           " NUMA node(s) with CPUs to place the instances of '" + Name() +
+           "' on")
+              .c_str());
+    }
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::ParseBatchBuckets(triton::common::TritonJson::Value& params)
+{
+  std::string value;
+  ReadParameter(params, "BATCH_BUCKETS", &value);
+  std::transform(
+      value.begin(), value.end(), value.begin(),
+      [](unsigned char c) { return std::tolower(c); });
+  if (value.empty()) {
+    return nullptr;
+  }
+
+  const size_t max_batch_size = MaxBatchSize();
+  RETURN_ERROR_IF_TRUE(
+      max_batch_size == 0, TRITONSERVER_ERROR_INVALID_ARG,
+      std::string("the parameter 'BATCH_BUCKETS' requires the model '") +
+          Name() + "' to support batching");
+
+  std::set<size_t> buckets;
+  if (value.compare("auto") == 0) {
+    // Powers of two up to the max_batch_size.
+    for (size_t bucket = 1; bucket < max_batch_size; bucket *= 2) {
+      buckets.insert(bucket);
+    }
+  } else {
+    std::stringstream ss(value);
+    std::string bucket;
+    while (std::getline(ss, bucket, ',')) {
+      bucket.erase(0, bucket.find_first_not_of(' '));
+      bucket.erase(bucket.find_last_not_of(' ') + 1);
+      size_t bucket_size = 0;
+      if (!ParseSize(bucket, &bucket_size) || (bucket_size == 0) ||
+          (bucket_size > max_batch_size)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            (std::string("expected the parameter 'BATCH_BUCKETS' to be AUTO "
+                         "or a comma-separated list of batch sizes between 1 "
+                         "and ") +
+             std::to_string(max_batch_size) + ", got " + value)
+                .c_str());
+      }
+      buckets.insert(bucket_size);
+    }
   }
 
+  // Any batch up to the max_batch_size must fit in a bucket.
+  buckets.insert(max_batch_size);
+  batch_buckets_.assign(buckets.begin(), buckets.end());
+
   return nullptr;
 }
 
@@ -303,6 +849,10 @@ ModelState::ParseParameters(const std::string& device)
           ParseParameter("CPU_BIND_THREAD", params, &device_config));
       RETURN_IF_ERROR(
           ParseParameter("CPU_THROUGHPUT_STREAMS", params, &device_config));
+      RETURN_IF_ERROR(
+          ParseParameter("PERFORMANCE_HINT", params, &device_config));
+      RETURN_IF_ERROR(ParseParameter(
+          "PERFORMANCE_HINT_NUM_REQUESTS", params, &device_config));
     }
   }
 
@@ -322,15 +872,20 @@ ModelState::LoadCpuExtensions(triton::common::TritonJson::Value& params)
     //del by zhaohb
     //const auto extension_ptr =
         //std::make_shared<InferenceEngine::Extension>(cpu_ext_path);
-    RETURN_IF_OPENVINO_ERROR(
-	//del by zhaohb
-        //inference_engine_.AddExtension(extension_ptr),
-	core.add_extension(cpu_ext_path),
-        " loading custom CPU extensions");
-    LOG_MESSAGE(
-        TRITONSERVER_LOG_INFO,
-        (std::string("CPU (MKLDNN) extensions is loaded") + cpu_ext_path)
-            .c_str());
+    std::lock_guard<std::mutex> lock(backend_state_->extensions_mu);
+    if (backend_state_->extension_paths.find(cpu_ext_path) ==
+        backend_state_->extension_paths.end()) {
+      RETURN_IF_OPENVINO_ERROR(
+          //del by zhaohb
+          //inference_engine_.AddExtension(extension_ptr),
+          backend_state_->core.add_extension(cpu_ext_path),
+          " loading custom CPU extensions");
+      backend_state_->extension_paths.insert(cpu_ext_path);
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_INFO,
+          (std::string("CPU (MKLDNN) extensions is loaded") + cpu_ext_path)
+              .c_str());
+    }
   }
 
   return nullptr;
@@ -354,6 +909,27 @@ ModelState::ParseBoolParameter(
   return nullptr;
 }
 
+TRITONSERVER_Error*
+ModelState::ParseNumberParameter(
+    const std::string& mkey, triton::common::TritonJson::Value& params,
+    size_t* setting)
+{
+  std::string value;
+  ReadParameter(params, mkey, &(value));
+  if (value.empty()) {
+    return nullptr;
+  }
+  if (!ParseSize(value, setting)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("expected the parameter '") + mkey +
+         "' to be a number, got " + value)
+            .c_str());
+  }
+
+  return nullptr;
+}
+
 TRITONSERVER_Error*
 ModelState::ParseParameter(
     const std::string& mkey, triton::common::TritonJson::Value& params,
@@ -426,6 +1002,28 @@ ModelState::ParseParameterHelper(
               .c_str());
     }
     *ov_key = CONFIG_KEY(CPU_THROUGHPUT_STREAMS);
+  } else if (mkey.compare("PERFORMANCE_HINT") == 0) {
+    if (value->compare("latency") == 0) {
+      *value = "LATENCY";
+    } else if (value->compare("throughput") == 0) {
+      *value = "THROUGHPUT";
+    } else {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("expected the parameter '") + mkey +
+           "' to be either LATENCY or THROUGHPUT, got " + *value)
+              .c_str());
+    }
+    *ov_key = ov::hint::performance_mode.name();
+  } else if (mkey.compare("PERFORMANCE_HINT_NUM_REQUESTS") == 0) {
+    if (!IsNumber(*value)) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("expected the parameter '") + mkey +
+           "' to be a non-negative number, got " + *value)
+              .c_str());
+    }
+    *ov_key = ov::hint::num_requests.name();
   } else {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INVALID_ARG,
@@ -437,30 +1035,18 @@ ModelState::ParseParameterHelper(
   return nullptr;
 }
 
-TRITONSERVER_Error*
-ModelState::ConfigureInferenceEngine()
-{
-  for (auto&& item : config_) {
-    RETURN_IF_OPENVINO_ERROR(
-        core.set_property(item.first, item.second),
-        //inference_engine_.SetConfig(item.second, item.first),
-        "configuring inference engine");
-  }
-
-  return nullptr;
-}
-
 TRITONSERVER_Error*
 ModelState::LoadNetwork(
-    const std::string& device,
+    const std::string& device, const int numa_node,
     const std::map<std::string, ov::AnyMap> network_config)
     //del by zhaohb
     //const std::map<std::string, std::string> network_config)
 {
+  const std::string network_key = NetworkKey(device, numa_node);
   RETURN_ERROR_IF_FALSE(
-      NetworkNotLoaded(device), TRITONSERVER_ERROR_INTERNAL,
+      NetworkNotLoaded(network_key), TRITONSERVER_ERROR_INTERNAL,
       std::string("attempt to load model '") + Name() + "' on device '" +
-          device + "' more than once");
+          network_key + "' more than once");
 
 #if 0
   LOG_MESSAGE(
@@ -474,209 +1060,825 @@ ModelState::LoadNetwork(
       TRITONSERVER_LOG_VERBOSE,
       (std::string("Device info: \n") +
        // change by zhaohb for ov 2022.1
-       ConvertVersionMapToString(core.get_versions(device)))
+       ConvertVersionMapToString(backend_state_->core.get_versions(device)))
        //ConvertVersionMapToString(inference_engine_.GetVersions(device)))
           .c_str());
 
 #endif
-  // change by zhaohb for ov 2022.1
+  // The properties are passed along with the network to compile instead
+  // of being set on the core shared by all the models.
   for (auto&& item : network_config) {
-      core.set_property(item.first, item.second);
+    config_[item.first].insert(item.second.begin(), item.second.end());
+  }
+  ov::AnyMap properties = config_[device];
+
+  // The network of a NUMA node runs as many threads as the node has CPUs.
+  // It is compiled from a thread restricted to the node, so that the
+  // threads the plugin creates meanwhile inherit the restriction, and the
+  // plugin must not pin them to CPUs of its own choosing. The threading
+  // runtime of OpenVINO (TBB by default) may however run the inference
+  // on a pool of workers shared by all the networks of the process, which
+  // VerifyNumaThreads() checks for once the network is loaded.
+  std::unique_ptr<ScopedThreadAffinity> numa_affinity;
+  if (numa_node >= 0) {
+    const std::vector<int>& cpus = numa_nodes_[numa_node];
+    properties.erase(CONFIG_KEY(CPU_THREADS_NUM));
+    properties.erase(CONFIG_KEY(CPU_BIND_THREAD));
+    properties[ov::inference_num_threads.name()] = (int32_t)cpus.size();
+    properties[ov::affinity.name()] = ov::Affinity::NONE;
+    numa_affinity.reset(new ScopedThreadAffinity(cpus));
   }
 
-  RETURN_IF_OPENVINO_ASSIGN_ERROR(
-      executable_network_[device],
-      // change by zhaohb for ov 2022.1
-      //inference_engine_.LoadNetwork(network_, device, network_config),
-      core.compile_model(network_, device),
-      "loading network");
-
-  const std::vector<ov::Output<const ov::Node>> inputs = executable_network_[device].inputs();
-  for (const ov::Output<const ov::Node> input : inputs) {
-	  const std::string name = input.get_names().empty() ? "NONE" : input.get_any_name();
-          name_node_map[name] = input;
-          //printf("input_name: %s, idx: %ld\n", name.c_str(), input.get_index());
+  // The per-layer profile can only be read from the infer requests of a
+  // network compiled to collect it.
+  if (profiling_interval_ > 0) {
+    properties[ov::enable_profiling.name()] = true;
   }
-  return nullptr;  // success
-}
 
-TRITONSERVER_Error*
-ModelState::CreateInferRequest(
-    const std::string& device, ov::InferRequest* infer_request)
-{
-  RETURN_IF_OPENVINO_ASSIGN_ERROR(
-      *infer_request, executable_network_[device].create_infer_request(),
-      "creating infer request object");
+  network_targets_[network_key] = {device, numa_node, properties};
 
-  return nullptr;
-}
+  if (batch_buckets_.empty()) {
+    // change by zhaohb for ov 2022.1
+    //inference_engine_.LoadNetwork(network_, device, network_config),
+    RETURN_IF_ERROR(CompileModel(
+        network_, device, properties, "",
+        &executable_network_[network_key]));
+  } else {
+    // Load a network with a static batch for each bucket.
+    auto& bucket_networks = batch_bucket_network_[network_key];
+    for (const size_t bucket : batch_buckets_) {
+      std::shared_ptr<ov::Model> bucket_network;
+      RETURN_IF_OPENVINO_ASSIGN_ERROR(
+          bucket_network, network_->clone(), "cloning network");
+      RETURN_IF_ERROR(ReshapeBatch(bucket_network, ov::Dimension(bucket)));
+      RETURN_IF_ERROR(CompileModel(
+          bucket_network, device, properties,
+          "batch=" + std::to_string(bucket), &bucket_networks[bucket]));
+    }
+    executable_network_[network_key] = bucket_networks.rbegin()->second;
 
-TRITONSERVER_Error* ModelState::SetNameNodeMap(std::map<std::string, ov::Output<const ov::Node> > * name_node_map_)
-{
-  *name_node_map_ = name_node_map;
-  return nullptr;
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("loaded model '") + Name() + "' for " +
+         std::to_string(batch_buckets_.size()) + " batch buckets")
+            .c_str());
+  }
+
+  RETURN_IF_ERROR(LogExecutionLayout(network_key, properties));
+  if (numa_node >= 0) {
+    LOG_IF_ERROR(
+        VerifyNumaThreads(network_key, numa_node),
+        "failed to verify the threads of the network on its NUMA node");
+  }
+
+  return nullptr;  // success
 }
 
-bool
-ModelState::NetworkNotRead()
+std::string
+ModelState::NetworkKey(const std::string& device, const int numa_node)
 {
-  return !network_read_;
+  return (numa_node < 0) ? device
+                         : device + "@numa" + std::to_string(numa_node);
 }
 
-bool
-ModelState::NetworkNotLoaded(const std::string device)
+void
+ModelState::AssignNumaNode(int* numa_node)
 {
-  auto itr = executable_network_.find(device);
-  return (itr == executable_network_.end());
+  *numa_node = -1;
+  if (!enable_numa_placement_ || (numa_nodes_.size() < 2)) {
+    return;
+  }
+
+  // Spread the instances evenly over the nodes.
+  auto nit = numa_nodes_.begin();
+  std::advance(nit, numa_instance_count_++ % numa_nodes_.size());
+  *numa_node = nit->first;
 }
 
 TRITONSERVER_Error*
-ModelState::ValidateConfigureNetwork()
+ModelState::VerifyNumaThreads(
+    const std::string& network_key, const int numa_node)
 {
-#if 0
-  size_t expected_input_cnt = 0;
-  {
-    triton::common::TritonJson::Value inputs;
-    if (model_config_.Find("input", &inputs)) {
-      expected_input_cnt = inputs.ArraySize();
+  ov::CompiledModel& compiled = executable_network_[network_key];
+  ov::InferRequest infer_request;
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      infer_request, compiled.create_infer_request(),
+      "creating infer request");
+  for (const auto& input : compiled.inputs()) {
+    if (input.get_partial_shape().is_dynamic()) {
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_VERBOSE,
+          (std::string("not verifying the threads of model '") + Name() +
+           "' on NUMA node " + std::to_string(numa_node) +
+           ", its inputs have dynamic shapes")
+              .c_str());
+      return nullptr;
     }
+    ov::Tensor tensor;
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        tensor, infer_request.get_tensor(input), "getting input tensor");
+    memset(tensor.data(), 0, tensor.get_byte_size());
   }
 
-  //printf("expected_input_cnt: %ld\n", expected_input_cnt);
-  //del by zhaohb
-  //RETURN_IF_ERROR(ValidateInputs(expected_input_cnt));
-  //RETURN_IF_ERROR(ValidateOutputs());
-#endif
-  return nullptr;  // success
-}
+  // The threads that ran meanwhile, which may include those of other
+  // work of the process, and the CPUs they may run on. Shared workers are
+  // created by the first inference of the process, restricted to the
+  // node of the first network loaded, so the next networks find them
+  // outside their node.
+  std::map<int, uint64_t> before_ns, after_ns;
+  RETURN_IF_ERROR(ReadThreadCpuTimes(&before_ns));
+  for (size_t i = 0; i < 3; i++) {
+    RETURN_IF_OPENVINO_ERROR(infer_request.infer(), "running inference");
+  }
+  RETURN_IF_ERROR(ReadThreadCpuTimes(&after_ns));
+
+  const std::vector<int>& node_cpus = numa_nodes_[numa_node];
+  size_t ran_count = 0;
+  size_t escaped_count = 0;
+  for (const auto& thread : after_ns) {
+    auto bit = before_ns.find(thread.first);
+    if ((bit != before_ns.end()) && (bit->second >= thread.second)) {
+      continue;
+    }
+    std::vector<int> cpus;
+    TRITONSERVER_Error* err = GetThreadAffinity(thread.first, &cpus);
+    if (err != nullptr) {
+      TRITONSERVER_ErrorDelete(err);
+      continue;
+    }
+    ran_count++;
+    for (const int cpu : cpus) {
+      if (std::find(node_cpus.begin(), node_cpus.end(), cpu) ==
+          node_cpus.end()) {
+        escaped_count++;
+        break;
+      }
+    }
+  }
 
-#if 0
-TRITONSERVER_Error*
-ModelState::ValidateInputs(const size_t expected_input_cnt)
-{
-  InferenceEngine::InputsDataMap input_tensor_infos;
-  //RETURN_IF_ERROR(GetInputsInfo(&input_tensor_infos));
-  if (input_tensor_infos.size() != expected_input_cnt) {
-    return TRITONSERVER_ErrorNew(
-        TRITONSERVER_ERROR_INVALID_ARG,
-        (std::string("unable to load model '") + Name() +
-         "', configuration expects " + std::to_string(expected_input_cnt) +
-         " inputs, model provides " + std::to_string(input_tensor_infos.size()))
+  if (escaped_count > 0) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_WARN,
+        (std::string("the inference of model '") + Name() +
+         "' on NUMA node " + std::to_string(numa_node) + " ran on " +
+         std::to_string(escaped_count) + " of " + std::to_string(ran_count) +
+         " threads not restricted to the node: the threading runtime of "
+         "OpenVINO shares its workers between the networks of the process, "
+         "so the instances on the node are not confined to it")
+            .c_str());
+  } else {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("the inference of model '") + Name() +
+         "' on NUMA node " + std::to_string(numa_node) + " ran on " +
+         std::to_string(ran_count) + " threads restricted to the node")
             .c_str());
   }
 
-  std::set<std::string> input_tensor_names;
-  for (const auto& input_tensor_info : input_tensor_infos) {
-    input_tensor_names.insert(input_tensor_info.first);
-  }
+  return nullptr;
+}
 
-  InferenceEngine::ICNNNetwork::InputShapes model_shapes;
-  if (reshape_io_layers_) {
+TRITONSERVER_Error*
+ModelState::InferRequestCount(const std::string& network_key, size_t* count)
+{
+  *count = infer_request_count_;
+  if (*count == 0) {
+    // The instances share the compiled network, so its optimal number of
+    // infer requests is split among them.
+    uint32_t optimal_count;
     RETURN_IF_OPENVINO_ASSIGN_ERROR(
-        model_shapes, network_.getInputShapes(),
-        "retrieving original shapes from the network");
+        optimal_count,
+        executable_network_[network_key].get_property(
+            ov::optimal_number_of_infer_requests),
+        "reading optimal number of infer requests");
+    size_t instance_count;
+    RETURN_IF_ERROR(InstanceCount(&instance_count));
+    *count = std::max<size_t>(
+        (optimal_count + instance_count - 1) / instance_count, 1);
   }
 
-  triton::common::TritonJson::Value ios;
-  RETURN_IF_ERROR(model_config_.MemberAsArray("input", &ios));
-  for (size_t i = 0; i < ios.ArraySize(); i++) {
-    triton::common::TritonJson::Value io;
-    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
-    std::string io_name;
-    RETURN_IF_ERROR(io.MemberAsString("name", &io_name));
-    std::string io_dtype;
-    RETURN_IF_ERROR(io.MemberAsString("data_type", &io_dtype));
+  return nullptr;
+}
 
-    auto iit = input_tensor_infos.find(io_name);
-    if (iit == input_tensor_infos.end()) {
-      RETURN_IF_ERROR(CheckAllowedModelInput(io, input_tensor_names));
-    }
+TRITONSERVER_Error*
+ModelState::MicroBatchLayout(
+    const std::string& network_key, size_t* size, size_t* count)
+{
+  *size = 0;
+  *count = 0;
+  if ((micro_batch_size_ == 0) && !micro_batch_auto_) {
+    return nullptr;
+  }
 
-    auto openvino_precision = ModelConfigDataTypeToOpenVINOPrecision(io_dtype);
-    if (openvino_precision == InferenceEngine::Precision::UNSPECIFIED) {
-      return TRITONSERVER_ErrorNew(
-          TRITONSERVER_ERROR_INTERNAL,
-          (std::string("unsupported datatype ") + io_dtype + " for input '" +
-           io_name + "' for model '" + Name() + "'")
-              .c_str());
-    }
-    RETURN_IF_OPENVINO_ERROR(
-        iit->second->setPrecision(openvino_precision),
-        std::string("setting precision for " + io_name).c_str());
+  // There is no point in running more micro-batches at once than the
+  // network has streams to run them on, which the optimal number of
+  // infer requests accounts for.
+  uint32_t optimal_count;
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      optimal_count,
+      executable_network_[network_key].get_property(
+          ov::optimal_number_of_infer_requests),
+      "reading optimal number of infer requests");
+  optimal_count = std::max(optimal_count, 1u);
+
+  const size_t max_batch_size = MaxBatchSize();
+  *size = micro_batch_auto_
+              ? (max_batch_size + optimal_count - 1) / optimal_count
+              : micro_batch_size_;
+  *count = std::min<size_t>(
+      (max_batch_size + *size - 1) / *size, optimal_count);
+  if (*count < 2) {
+    *size = 0;
+    *count = 0;
+  }
 
-    // If a reshape is provided for the input then use that when
-    // validating that the model matches what is expected.
-    std::vector<int64_t> dims;
-    triton::common::TritonJson::Value reshape;
-    if (io.Find("reshape", &reshape)) {
-      RETURN_IF_ERROR(ParseShape(reshape, "shape", &dims));
-    } else {
-      RETURN_IF_ERROR(ParseShape(io, "dims", &dims));
-    }
+  return nullptr;
+}
 
-    if (reshape_io_layers_) {
-      int index = (MaxBatchSize() != 0) ? 1 : 0;
-      for (const auto dim : dims) {
-        model_shapes[io_name][index++] = dim;
+TRITONSERVER_Error*
+ModelState::InstanceCount(size_t* count)
+{
+  *count = 0;
+  triton::common::TritonJson::Value groups;
+  if (model_config_.Find("instance_group", &groups)) {
+    for (size_t i = 0; i < groups.ArraySize(); i++) {
+      triton::common::TritonJson::Value group;
+      RETURN_IF_ERROR(groups.IndexAsObject(i, &group));
+      int64_t group_count = 1;
+      if (group.Find("count")) {
+        RETURN_IF_ERROR(group.MemberAsInt("count", &group_count));
       }
-    } else {
-      RETURN_IF_ERROR(CompareDimsSupported(
-          Name(), io_name, iit->second->getTensorDesc().getDims(), dims,
-          MaxBatchSize(), false /* compare_exact */));
+      *count += std::max<int64_t>(group_count, 0);
     }
   }
+  *count = std::max<size_t>(*count, 1);
 
-  if (reshape_io_layers_) {
-    network_.reshape(model_shapes);
-  }
-
-  // Configuring the network to handle the max_batch_size
-  RETURN_IF_OPENVINO_ERROR(
-      SetBatchSize(MaxBatchSize(), &network_), "setting max batch size");
-  return nullptr;  // success
+  return nullptr;
 }
 
 TRITONSERVER_Error*
-ModelState::ValidateOutputs()
+ModelState::LogExecutionLayout(
+    const std::string& network_key, const ov::AnyMap& properties)
 {
-  InferenceEngine::OutputsDataMap output_tensor_infos;
+  ov::CompiledModel& compiled = executable_network_[network_key];
+  uint32_t optimal_count;
   RETURN_IF_OPENVINO_ASSIGN_ERROR(
-      output_tensor_infos, network_.getOutputsInfo(),
-      "getting output infos for validation");
-  std::set<std::string> output_tensor_names;
-  for (const auto& output_tensor_info : output_tensor_infos) {
-    output_tensor_names.insert(output_tensor_info.first);
+      optimal_count,
+      compiled.get_property(ov::optimal_number_of_infer_requests),
+      "reading optimal number of infer requests");
+  std::string streams;
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      streams, compiled.get_property(ov::num_streams.name()).as<std::string>(),
+      "reading number of streams");
+  std::string hint = "none";
+  auto hit = properties.find(ov::hint::performance_mode.name());
+  if (hit != properties.end()) {
+    hint = hit->second.as<std::string>();
   }
 
-  triton::common::TritonJson::Value ios;
-  RETURN_IF_ERROR(model_config_.MemberAsArray("output", &ios));
-  for (size_t i = 0; i < ios.ArraySize(); i++) {
-    triton::common::TritonJson::Value io;
-    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
-    std::string io_name;
-    RETURN_IF_ERROR(io.MemberAsString("name", &io_name));
-    std::string io_dtype;
-    RETURN_IF_ERROR(io.MemberAsString("data_type", &io_dtype));
+  // A synchronous instance runs one infer request at a time, so keeping
+  // all the streams busy takes as many instances as optimal requests. An
+  // asynchronous instance runs its whole pool at once.
+  size_t instance_count;
+  RETURN_IF_ERROR(InstanceCount(&instance_count));
+  const size_t recommended_count =
+      EnableAsyncExecution() ? 1 : std::max(optimal_count, 1u);
+  size_t request_count;
+  RETURN_IF_ERROR(InferRequestCount(network_key, &request_count));
 
-    auto iit = output_tensor_infos.find(io_name);
-    if (iit == output_tensor_infos.end()) {
-      RETURN_IF_ERROR(CheckAllowedModelOutput(io, output_tensor_names));
-    }
+  LOG_MESSAGE(
+      TRITONSERVER_LOG_INFO,
+      (std::string("model '") + Name() + "' compiled on " + network_key +
+       " with performance hint " + hint + ": " + streams + " streams, " +
+       std::to_string(optimal_count) + " optimal infer requests; " +
+       std::to_string(instance_count) + " instance(s) with " +
+       std::to_string(request_count) +
+       " infer request(s) each, recommended instance_group count " +
+       std::to_string(recommended_count) +
+       (EnableAsyncExecution() ? " with NUM_INFER_REQUESTS AUTO" : ""))
+          .c_str());
 
-    auto openvino_precision = ModelConfigDataTypeToOpenVINOPrecision(io_dtype);
-    if (openvino_precision == InferenceEngine::Precision::UNSPECIFIED) {
-      return TRITONSERVER_ErrorNew(
-          TRITONSERVER_ERROR_INTERNAL,
-          (std::string("unsupported datatype ") + io_dtype + " for input '" +
-           io_name + "' for model '" + Name() + "'")
-              .c_str());
-    }
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::CreateInferRequest(
+    const std::string& network_key, const size_t batch_bucket,
+    ov::InferRequest* infer_request)
+{
+  ov::CompiledModel* compiled;
+  RETURN_IF_ERROR(CompiledNetwork(network_key, batch_bucket, &compiled));
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      *infer_request, compiled->create_infer_request(),
+      "creating infer request object");
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::CompileModel(
+    const std::shared_ptr<ov::Model>& network, const std::string& device,
+    const ov::AnyMap& properties, const std::string& variant,
+    ov::CompiledModel* compiled)
+{
+  std::string cache_path;
+  if (!cache_dir_.empty()) {
+    uint64_t key;
+    RETURN_IF_ERROR(ModelCacheKey(device, properties, variant, &key));
+    char key_str[17];
+    snprintf(key_str, sizeof(key_str), "%016llx", (unsigned long long)key);
+    cache_path = JoinPath({cache_dir_, std::string(key_str) + ".blob"});
+
+    bool exists = false;
+    RETURN_IF_ERROR(FileExists(cache_path, &exists));
+    if (exists) {
+      uint64_t start_ns = 0;
+      SET_TIMESTAMP(start_ns);
+      TRITONSERVER_Error* err =
+          ImportModel(cache_path, device, properties, compiled);
+      if (err == nullptr) {
+        uint64_t end_ns = 0;
+        SET_TIMESTAMP(end_ns);
+        if (metrics_ != nullptr) {
+          metrics_->CacheHit(end_ns - start_ns);
+        }
+        LOG_MESSAGE(
+            TRITONSERVER_LOG_INFO,
+            (std::string("imported model '") + Name() + "' " + variant +
+             " from the model cache '" + cache_path + "' in " +
+             std::to_string((end_ns - start_ns) / 1000000) + " ms")
+                .c_str());
+        return nullptr;
+      }
+
+      // An entry that can't be imported, for instance one exported by a
+      // different build of the plugin, is replaced by a new one.
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_WARN,
+          (std::string("ignoring the model cache entry of model '") + Name() +
+           "': " + TRITONSERVER_ErrorMessage(err))
+              .c_str());
+      TRITONSERVER_ErrorDelete(err);
+    }
+  }
+
+  uint64_t start_ns = 0;
+  SET_TIMESTAMP(start_ns);
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      *compiled,
+      backend_state_->core.compile_model(network, device, properties),
+      "loading network" + (variant.empty() ? "" : " for " + variant));
+  uint64_t end_ns = 0;
+  SET_TIMESTAMP(end_ns);
+  if (metrics_ != nullptr) {
+    metrics_->ObserveCompile(end_ns - start_ns);
+  }
+
+  if (!cache_path.empty()) {
+    if (metrics_ != nullptr) {
+      metrics_->CacheMiss();
+    }
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("compiled model '") + Name() + "' " + variant + " in " +
+         std::to_string((end_ns - start_ns) / 1000000) +
+         " ms, not found in the model cache")
+            .c_str());
+
+    // The network is compiled again next time if it can't be published.
+    LOG_IF_ERROR(
+        ExportModel(*compiled, cache_path),
+        "failed to publish to the model cache");
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::ImportModel(
+    const std::string& cache_path, const std::string& device,
+    const ov::AnyMap& properties, ov::CompiledModel* compiled)
+{
+  std::ifstream blob(cache_path, std::ios::binary);
+  RETURN_ERROR_IF_FALSE(
+      blob.is_open(), TRITONSERVER_ERROR_UNAVAILABLE,
+      std::string("unable to open '") + cache_path + "'");
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      *compiled,
+      backend_state_->core.import_model(blob, device, properties),
+      "importing network from '" + cache_path + "'");
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::ExportModel(
+    ov::CompiledModel& compiled, const std::string& cache_path)
+{
+  RETURN_IF_ERROR(MakeDirectory(cache_dir_));
+
+  // Other processes loading the same model may publish the same entry
+  // concurrently, so the entry is written under a name private to this
+  // process, by a random token drawn once per process, and renamed into
+  // place, which either replaces the entry atomically by an identical one
+  // or fails without side effect.
+  static const uint64_t process_token = []() {
+    std::random_device random;
+    return ((uint64_t)random() << 32) | random();
+  }();
+  static std::atomic<uint64_t> export_count(0);
+  const std::string tmp_path = cache_path + ".tmp." +
+                               std::to_string(process_token) + "." +
+                               std::to_string(export_count++);
+  {
+    std::ofstream blob(tmp_path, std::ios::binary);
+    RETURN_ERROR_IF_FALSE(
+        blob.is_open(), TRITONSERVER_ERROR_INTERNAL,
+        std::string("unable to create '") + tmp_path + "'");
+    std::string error_str;
+    try {
+      compiled.export_model(blob);
+      blob.close();
+    }
+    catch (const std::exception& error) {
+      error_str = error.what();
+    }
+    if (error_str.empty() && !blob) {
+      error_str = "failed to write '" + tmp_path + "'";
+    }
+    if (!error_str.empty()) {
+      std::remove(tmp_path.c_str());
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          (std::string("openvino error in exporting network : ") + error_str)
+              .c_str());
+    }
+  }
+
+  TRITONSERVER_Error* err = RenameFile(tmp_path, cache_path);
+  if (err != nullptr) {
+    std::remove(tmp_path.c_str());
+    return err;
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::ModelCacheKey(
+    const std::string& device, const ov::AnyMap& properties,
+    const std::string& variant, uint64_t* key)
+{
+  // The compiled network depends on the model files, the plugin that
+  // compiled it and the device it was compiled for, the properties it
+  // was compiled with and the reshaping done from the model
+  // configuration.
+  uint64_t hash = HashBytes(&model_hash_, sizeof(model_hash_));
+  hash = HashString(ov::get_openvino_version().buildNumber, hash);
+  hash = HashString(device, hash);
+  std::string device_name;
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      device_name,
+      backend_state_->core.get_property(device, ov::device::full_name),
+      "reading the full name of device " + device);
+  hash = HashString(device_name, hash);
+  for (const auto& property : properties) {
+    std::string value;
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        value, property.second.as<std::string>(),
+        "reading property " + property.first);
+    hash = HashString(property.first, hash);
+    hash = HashString(value, hash);
+  }
+  triton::common::TritonJson::WriteBuffer buffer;
+  RETURN_IF_ERROR(model_config_.Write(&buffer));
+  hash = HashString(buffer.Contents(), hash);
+  *key = HashString(variant, hash);
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::CompiledNetwork(
+    const std::string& network_key, const size_t batch_bucket,
+    ov::CompiledModel** compiled)
+{
+  if (batch_bucket == 0) {
+    auto itr = executable_network_.find(network_key);
+    RETURN_ERROR_IF_TRUE(
+        itr == executable_network_.end(), TRITONSERVER_ERROR_INTERNAL,
+        std::string("model '") + Name() + "' is not loaded on device '" +
+            network_key + "'");
+    *compiled = &itr->second;
+  } else {
+    auto itr = batch_bucket_network_[network_key].find(batch_bucket);
+    RETURN_ERROR_IF_TRUE(
+        itr == batch_bucket_network_[network_key].end(),
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string("model '") + Name() + "' is not loaded on device '" +
+            network_key + "' for batch size " +
+            std::to_string(batch_bucket));
+    *compiled = &itr->second;
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::PrunedNetwork(
+    const std::string& network_key, const uint64_t output_mask,
+    const std::vector<const char*>& output_names,
+    std::shared_ptr<ov::CompiledModel>* compiled)
+{
+  compiled->reset();
+
+  std::lock_guard<std::mutex> lock(pruned_mu_);
+  const auto key = std::make_pair(network_key, output_mask);
+  auto it = pruned_variants_.find(key);
+  if (it != pruned_variants_.end()) {
+    it->second.last_use = ++pruned_use_count_;
+    if (it->second.compiled.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready) {
+      *compiled = it->second.compiled.get();
+    }
+    return nullptr;
+  }
+
+  // Make room by dropping the least recently used network done compiling,
+  // the infer requests created from it keep it alive until released.
+  if (pruned_variants_.size() >= max_pruned_variants_) {
+    auto lru = pruned_variants_.end();
+    for (auto vit = pruned_variants_.begin(); vit != pruned_variants_.end();
+         ++vit) {
+      if ((vit->second.compiled.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready) &&
+          ((lru == pruned_variants_.end()) ||
+           (vit->second.last_use < lru->second.last_use))) {
+        lru = vit;
+      }
+    }
+    if (lru == pruned_variants_.end()) {
+      return nullptr;
+    }
+    pruned_variants_.erase(lru);
+  }
+
+  auto tit = network_targets_.find(network_key);
+  RETURN_ERROR_IF_TRUE(
+      tit == network_targets_.end(), TRITONSERVER_ERROR_INTERNAL,
+      std::string("model '") + Name() + "' is not loaded on '" + network_key +
+          "'");
+  std::vector<std::string> kept_outputs;
+  for (size_t idx = 0; idx < output_names.size(); idx++) {
+    if ((output_mask >> idx) & 1) {
+      kept_outputs.push_back(output_names[idx]);
+    }
+  }
+
+  const NetworkTarget target = tit->second;
+  PrunedVariant& variant = pruned_variants_[key];
+  variant.last_use = ++pruned_use_count_;
+  variant.compiled =
+      std::async(std::launch::async, [this, target, output_mask, kept_outputs] {
+        std::unique_ptr<ScopedThreadAffinity> numa_affinity;
+        if (target.numa_node >= 0) {
+          numa_affinity.reset(
+              new ScopedThreadAffinity(NumaNodeCpus(target.numa_node)));
+        }
+
+        std::shared_ptr<ov::CompiledModel> pruned_compiled(
+            new ov::CompiledModel());
+        TRITONSERVER_Error* err = CompilePrunedModel(
+            target, output_mask, kept_outputs, pruned_compiled.get());
+        if (err != nullptr) {
+          LOG_MESSAGE(
+              TRITONSERVER_LOG_ERROR,
+              (std::string("failed to compile model '") + Name() +
+               "' pruned to " + std::to_string(kept_outputs.size()) +
+               " outputs, running the whole network instead: " +
+               TRITONSERVER_ErrorMessage(err))
+                  .c_str());
+          TRITONSERVER_ErrorDelete(err);
+          pruned_compiled.reset();
+        }
+        return pruned_compiled;
+      }).share();
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::CompilePrunedModel(
+    const NetworkTarget& target, const uint64_t output_mask,
+    const std::vector<std::string>& kept_outputs, ov::CompiledModel* compiled)
+{
+  // Keep the results of the kept outputs along with all the parameters,
+  // so that the pruned network has the same inputs as the whole one.
+  std::shared_ptr<ov::Model> network;
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      network, network_->clone(), "cloning network");
+  ov::ResultVector results;
+  for (const auto& result : network->get_results()) {
+    const std::unordered_set<std::string>& names =
+        result->input_value(0).get_names();
+    for (const auto& name : kept_outputs) {
+      if (names.find(name) != names.end()) {
+        results.push_back(result);
+        break;
+      }
+    }
+  }
+  RETURN_ERROR_IF_FALSE(
+      results.size() == kept_outputs.size(), TRITONSERVER_ERROR_INTERNAL,
+      std::string("failed to find the outputs to keep in model '") + Name() +
+          "'");
+
+  std::shared_ptr<ov::Model> pruned_network;
+  RETURN_IF_OPENVINO_ASSIGN_ERROR(
+      pruned_network,
+      std::make_shared<ov::Model>(
+          results, network->get_parameters(), network->get_friendly_name()),
+      "pruning network");
+
+  std::stringstream variant;
+  variant << "outputs=" << std::hex << output_mask;
+  uint64_t compile_start_ns = 0;
+  SET_TIMESTAMP(compile_start_ns);
+  RETURN_IF_ERROR(CompileModel(
+      pruned_network, target.device, target.properties, variant.str(),
+      compiled));
+  uint64_t compile_end_ns = 0;
+  SET_TIMESTAMP(compile_end_ns);
+
+  LOG_MESSAGE(
+      TRITONSERVER_LOG_INFO,
+      (std::string("loaded model '") + Name() + "' pruned to " +
+       std::to_string(kept_outputs.size()) + " outputs (" + variant.str() +
+       ") in " + std::to_string((compile_end_ns - compile_start_ns) / 1000000) +
+       " ms")
+          .c_str());
+
+  return nullptr;
+}
+
+bool
+ModelState::NetworkNotRead()
+{
+  return !network_read_;
+}
+
+bool
+ModelState::NetworkNotLoaded(const std::string network_key)
+{
+  auto itr = executable_network_.find(network_key);
+  return (itr == executable_network_.end());
+}
+
+TRITONSERVER_Error*
+ModelState::ValidateConfigureNetwork()
+{
+  // The outputs are validated against the reshaped network.
+  RETURN_IF_ERROR(ValidateInputs());
+  RETURN_IF_ERROR(ReshapeVariableDims());
+  RETURN_IF_ERROR(ValidateOutputs());
+
+  // Configuring the network to handle any batch size up to the
+  // max_batch_size, each execution then only computes its actual batch.
+  // With batch buckets the batch is instead set for each loaded network.
+  if ((MaxBatchSize() > 0) && !SkipDynamicBatchSize() &&
+      batch_buckets_.empty()) {
+    RETURN_IF_ERROR(ReshapeBatch(network_, ov::Dimension(1, MaxBatchSize())));
+  }
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+ModelState::ReshapeVariableDims()
+{
+  triton::common::TritonJson::Value ios;
+  RETURN_IF_ERROR(model_config_.MemberAsArray("input", &ios));
+
+  std::map<std::string, ov::PartialShape> partial_shapes;
+  for (size_t i = 0; i < ios.ArraySize(); i++) {
+    triton::common::TritonJson::Value io;
+    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
+    std::string io_name;
+    RETURN_IF_ERROR(io.MemberAsString("name", &io_name));
+
+    // If a reshape is provided for the input then it is the shape the
+    // model is given.
+    std::vector<int64_t> dims;
+    triton::common::TritonJson::Value reshape;
+    if (io.Find("reshape", &reshape)) {
+      RETURN_IF_ERROR(ParseShape(reshape, "shape", &dims));
+    } else {
+      RETURN_IF_ERROR(ParseShape(io, "dims", &dims));
+    }
+    const bool variable_dims =
+        (std::find(dims.begin(), dims.end(), -1) != dims.end());
+    if (!variable_dims && !reshape_io_layers_) {
+      continue;
+    }
+    has_variable_dims_ |= variable_dims;
+
+    // The batch dimension, if any, is kept as is and set along with the
+    // batch of the network.
+    ov::Output<ov::Node> input;
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        input, network_->input(io_name), "getting input " + io_name);
+    std::vector<ov::Dimension> partial_dims;
+    if (MaxBatchSize() > 0) {
+      const ov::PartialShape& model_shape = input.get_partial_shape();
+      partial_dims.push_back(
+          (model_shape.rank().is_static() && (model_shape.size() > 0))
+              ? model_shape[0]
+              : ov::Dimension::dynamic());
+    }
+    for (const auto dim : dims) {
+      partial_dims.push_back(
+          (dim == -1) ? ov::Dimension::dynamic() : ov::Dimension(dim));
+    }
+    partial_shapes[io_name] = ov::PartialShape(partial_dims);
+  }
+
+  if (!partial_shapes.empty()) {
     RETURN_IF_OPENVINO_ERROR(
-        iit->second->setPrecision(openvino_precision),
-        std::string("setting precision for " + io_name).c_str());
+        network_->reshape(partial_shapes),
+        "reshaping the inputs to the model configuration");
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::ReshapeBatch(
+    const std::shared_ptr<ov::Model>& network, const ov::Dimension& batch)
+{
+  // Mark up the batch in the layout of the inputs that do not specify one
+  // so that the batch dimension can be found by 'ov::set_batch'.
+  for (const auto& parameter : network->get_parameters()) {
+    if (parameter->get_layout().empty()) {
+      RETURN_IF_OPENVINO_ERROR(
+          parameter->set_layout(ov::Layout("N...")),
+          "setting batch layout for input " + parameter->get_friendly_name());
+    }
+  }
+
+  std::string error_str;
+  try {
+    ov::set_batch(network, batch);
+  }
+  catch (const std::exception& error) {
+    error_str = error.what();
+  }
+  if (!error_str.empty()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("unable to set the batch of model '") + Name() +
+         "' to " + batch.to_string() + ": " + error_str +
+         (batch.is_dynamic()
+              ? "... this error can be avoided by setting the "
+                "'SKIP_OV_DYNAMIC_BATCHSIZE' parameter in model "
+                "configuration to 'YES'"
+              : ""))
+            .c_str());
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelState::ValidateInputs()
+{
+  triton::common::TritonJson::Value ios;
+  RETURN_IF_ERROR(model_config_.MemberAsArray("input", &ios));
+  for (size_t i = 0; i < ios.ArraySize(); i++) {
+    triton::common::TritonJson::Value io;
+    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
+    std::string io_name;
+    RETURN_IF_ERROR(io.MemberAsString("name", &io_name));
+
+    ov::Output<ov::Node> input;
+    try {
+      input = network_->input(io_name);
+    }
+    catch (const std::exception& error) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("unable to load model '") + Name() +
+           "', configuration expects input '" + io_name +
+           "' which the model doesn't provide: " + error.what())
+              .c_str());
+    }
 
-    // If a reshape is provided for the input then use that when
-    // validating that the model matches what is expected.
+    // The inputs are reshaped to the configuration by
+    // ReshapeVariableDims() when 'RESHAPE_IO_LAYERS' is set. If a reshape
+    // is provided for the input then use that when validating that the
+    // model matches what is expected.
+    if (reshape_io_layers_) {
+      continue;
+    }
     std::vector<int64_t> dims;
     triton::common::TritonJson::Value reshape;
     if (io.Find("reshape", &reshape)) {
@@ -685,13 +1887,54 @@ ModelState::ValidateOutputs()
       RETURN_IF_ERROR(ParseShape(io, "dims", &dims));
     }
     RETURN_IF_ERROR(CompareDimsSupported(
-        Name(), io_name, iit->second->getTensorDesc().getDims(), dims,
-        MaxBatchSize(), true /* compare_exact */));
+        Name(), io_name, input.get_partial_shape(), dims, MaxBatchSize(),
+        false /* compare_exact */));
+  }
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+ModelState::ValidateOutputs()
+{
+  triton::common::TritonJson::Value ios;
+  RETURN_IF_ERROR(model_config_.MemberAsArray("output", &ios));
+  for (size_t i = 0; i < ios.ArraySize(); i++) {
+    triton::common::TritonJson::Value io;
+    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
+    std::string io_name;
+    RETURN_IF_ERROR(io.MemberAsString("name", &io_name));
+
+    ov::Output<ov::Node> output;
+    try {
+      output = network_->output(io_name);
+    }
+    catch (const std::exception& error) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("unable to load model '") + Name() +
+           "', configuration expects output '" + io_name +
+           "' which the model doesn't provide: " + error.what())
+              .c_str());
+    }
+
+    // If a reshape is provided for the output then use that when
+    // validating that the model matches what is expected. The batch of
+    // the network is set after the validation, so it isn't compared.
+    std::vector<int64_t> dims;
+    triton::common::TritonJson::Value reshape;
+    if (io.Find("reshape", &reshape)) {
+      RETURN_IF_ERROR(ParseShape(reshape, "shape", &dims));
+    } else {
+      RETURN_IF_ERROR(ParseShape(io, "dims", &dims));
+    }
+    RETURN_IF_ERROR(CompareDimsSupported(
+        Name(), io_name, output.get_partial_shape(), dims, MaxBatchSize(),
+        false /* compare_exact */));
   }
 
   return nullptr;  // success
 }
-#endif
 
 #if 0
 //del by zhaohb 
@@ -738,28 +1981,287 @@ class ModelInstanceState : public BackendModelInstance {
   // Execute...
   void ProcessRequests(
       TRITONBACKEND_Request** requests, const uint32_t request_count);
-  std::map<std::string, ov::Output<const ov::Node> > name_node_map_;
-  
+  // Runs 'requests' as one execution, whose inputs have the same shapes
+  // other than the batch.
+  void ExecuteRequests(
+      TRITONBACKEND_Request** requests, const uint32_t request_count,
+      const uint64_t exec_start_ns);
 
  private:
+  // The state of an execution that must be kept until its responses are
+  // sent, which with asynchronous execution happens after ProcessRequests
+  // has returned.
+  // An input that could not be bound directly and must be copied into
+  // the data of the request tensor once the collector has finished
+  // gathering it.
+  struct PendingCopy {
+    char* data;
+    const char* buffer;
+    size_t byte_size;
+  };
+
+  struct Payload {
+    std::vector<TRITONBACKEND_Request*> requests;
+    std::vector<TRITONBACKEND_Response*> responses;
+    // The collector of the inputs bound without copy, created by the
+    // executions that bind them only, as it allocates on creation. The
+    // inputs copied into the request tensors are gathered by the
+    // instance.
+    std::unique_ptr<BackendInputCollector> collector;
+    // Whether any of the requests asked for each output of the plan.
+    std::vector<bool> requested_outputs;
+    std::vector<char*> output_buffers;
+    size_t total_batch_size;
+    // The batch the infer request runs with, larger than the total batch
+    // size when the batch is padded up to a batch bucket.
+    size_t batch_size;
+    bool all_response_failed;
+    // The start of the Triton execution, shared by the executions it is
+    // split into, and the time this execution started waiting for the
+    // infer request.
+    uint64_t exec_start_ns;
+    uint64_t acquire_start_ns;
+    // The ends of the stages of the execution before and after the
+    // inference, along with the start of its preparation.
+    uint64_t prepare_start_ns;
+    uint64_t inputs_gathered_ns;
+    uint64_t inputs_copied_ns;
+    uint64_t compute_start_ns;
+    uint64_t compute_end_ns;
+    uint64_t outputs_scattered_ns;
+    // Whether the hardware counters are read around the stages of the
+    // execution, and their counts at the start and end of each stage.
+    bool perf_sampled;
+    std::array<PerfCounts, (size_t)PerfStage::COUNT> perf_start;
+    std::array<PerfCounts, (size_t)PerfStage::COUNT> perf_end;
+    // The number of micro-batches the batch is split into, 0 if it runs
+    // as a whole, and when running asynchronously the micro-batches still
+    // running along with the first error they raised.
+    size_t micro_batch_count;
+    std::mutex micro_batch_mu;
+    size_t pending_micro_batches;
+    std::exception_ptr micro_batch_exception;
+    // Scratch storage reused by the executions of the slot, which keep
+    // their capacity so that the executions don't allocate once warm.
+    std::vector<int64_t> shape;
+    ov::Shape tensor_shape;
+    ov::Shape request_shape;
+    std::vector<PendingCopy> pending_copies;
+    std::vector<ov::Tensor> micro_batch_inputs;
+    std::vector<ov::Tensor> micro_batch_outputs;
+    std::vector<ov::Shape> micro_batch_output_shapes;
+  };
+
+  // An input or output of an infer request: the port of the compiled
+  // model the infer request was created from, and the tensor allocated
+  // by the infer request, restored whenever the input or output falls
+  // back to the copy path after a buffer of a previous execution was
+  // bound to it directly.
+  struct BoundTensor {
+    ov::Output<const ov::Node> port;
+    ov::Tensor owned;
+    // For the inputs, the shape of the owned tensor, tracked along with it
+    // since the tensor only returns copies of its shape.
+    ov::Shape shape;
+    bool bound = false;
+    // For the inputs, the first row of the owned tensor from which all
+    // the rows are known to be zero, so that the padding of a batch is
+    // only zeroed where a previous batch wrote into it. SIZE_MAX if none
+    // is known to be zero.
+    size_t zero_rows_from = SIZE_MAX;
+  };
+
+  // An infer request together with its inputs and outputs, by their index
+  // in the binding plan of the instance.
+  struct BoundRequest {
+    ov::InferRequest infer_request;
+    std::vector<BoundTensor> inputs;
+    std::vector<BoundTensor> outputs;
+  };
+
+  // An entry of the pool together with the execution using it. The entry
+  // holds an infer request per batch bucket, or a single one keyed by 0
+  // when the model is not loaded with batch buckets, of which the
+  // execution uses the one fitting its batch.
+  struct InferSlot {
+    std::map<size_t, BoundRequest> requests;
+    BoundRequest* request;
+    // The infer requests running the micro-batches of the execution, into
+    // whose tensors those of 'request' are split.
+    std::vector<std::unique_ptr<BoundRequest>> micro_requests;
+    // The infer requests of the networks pruned to the outputs requested
+    // together, by output mask.
+    std::map<uint64_t, BoundRequest> pruned_requests;
+    Payload payload;
+  };
+
   ModelInstanceState(
       ModelState* model_state,
       TRITONBACKEND_ModelInstance* triton_model_instance);
 
-  TRITONSERVER_Error* SetBatch(const int batch_size);
+  // Splits 'requests' into groups of requests whose inputs have the same
+  // shapes other than the batch, in the order of their first request.
+  void GroupRequestsByShape(
+      TRITONBACKEND_Request** requests, const uint32_t request_count,
+      std::vector<std::vector<TRITONBACKEND_Request*>>* groups);
+  // Runs each of 'requests' as an execution of its own, for models that
+  // don't batch, starting as many at once as the pool has infer requests.
+  void ExecuteEachRequest(
+      TRITONBACKEND_Request** requests, const uint32_t request_count,
+      const uint64_t exec_start_ns);
+  // Adds the per-layer profile of the inference of 'slot' to the profile
+  // of the instance if the execution is sampled, and reports the profile
+  // when due.
+  void SampleProfile(InferSlot* slot);
+  // Reports the layers of the profile of the instance that took the most
+  // time, as a JSON line appended to 'PROFILING_OUTPUT' or logged.
+  TRITONSERVER_Error* ReportProfile();
+  // Writes the requests of the execution of 'slot' to the trace of the
+  // model if the execution is sampled or slower than the threshold.
+  TRITONSERVER_Error* CaptureExecution(InferSlot* slot);
+  // Sets on each response of the execution of 'slot' the durations of
+  // the stages of the execution up to the scatter of its outputs, in
+  // microseconds, and the batch it ran in.
+  TRITONSERVER_Error* SetLatencyParameters(InferSlot* slot);
+  // Decides whether the hardware counters are read around the stages of
+  // the execution of 'slot', and if so starts its first stage.
+  void StartPerfSample(InferSlot* slot);
+  // Reads the hardware counters at the start or the end of 'stage' of
+  // the execution of 'slot' if it is sampled: those of the calling
+  // thread, or for the inference, which runs on the threads of the
+  // device, those of the process over the window of the process, whose
+  // counts are in the end of the stage.
+  void ReadPerfCounters(InferSlot* slot, const PerfStage stage, const bool end);
+  // Adds the counts of the sampled execution of 'slot' to those of the
+  // instance, but those of the inference to those of the process, and
+  // reports the counts of the instance when due.
+  void ObservePerfCounts(InferSlot* slot);
+  // Logs the counts of the sampled executions since the last report.
+  void ReportPerfCounts();
+  // Records in the payload of 'slot' the outputs asked for by any of its
+  // requests, only those are read from the infer request.
+  TRITONSERVER_Error* SetRequestedOutputs(InferSlot* slot);
+  // Resolves the inputs and outputs of the instance into its binding
+  // plan.
+  TRITONSERVER_Error* BuildBindingPlan();
+  // Returns the index in the binding plan of the input 'name', given at
+  // 'hint' in the request, or the number of inputs if there is none.
+  size_t InputIndex(const char* name, const size_t hint);
+  // Creates the infer requests of the pool.
+  TRITONSERVER_Error* CreateInferSlots(const size_t count);
+  // Resolves the ports and tensors of the plan in 'request', created
+  // from 'compiled', which only has the outputs of the plan whose bit is
+  // set in 'output_mask'.
+  TRITONSERVER_Error* InitRequestTensors(
+      const ov::CompiledModel& compiled, const uint64_t output_mask,
+      BoundRequest* request);
+  // Runs the execution of 'slot' on an infer request of the network
+  // pruned to the outputs its requests asked for, once compiled.
+  TRITONSERVER_Error* SelectPrunedRequest(InferSlot* slot);
+  TRITONSERVER_Error* SetInferCallback(
+      InferSlot* slot, BoundRequest* request);
+  TRITONSERVER_Error* SetMicroBatchCallback(
+      InferSlot* slot, BoundRequest* request);
+  // Waits until an infer request of the pool is free and takes it.
+  InferSlot* AcquireSlot();
+  void ReleaseSlot(InferSlot* slot);
+  // The number of infer requests of the pool.
+  size_t SlotCount() { return slots_.size(); }
+  // Waits until all the executions in flight have completed.
+  void WaitForCompletion();
+  // Creates the responses and sets the inputs and outputs of the infer
+  // request for the requests of the payload of 'slot'. Returns false if
+  // there is nothing to run.
+  bool PrepareExecution(InferSlot* slot);
+  // Reads the outputs, sends the responses, reports the statistics and
+  // releases the requests of the payload of 'slot'.
+  void CompleteExecution(InferSlot* slot);
+  TRITONSERVER_Error* SetBatch(InferSlot* slot, const int batch_size);
   TRITONSERVER_Error* Infer(
-      std::vector<TRITONBACKEND_Response*>* responses,
+      InferSlot* slot, std::vector<TRITONBACKEND_Response*>* responses,
       const uint32_t response_count);
+  TRITONSERVER_Error* InferAsync(InferSlot* slot);
+  // Starts the inference of 'slot' without a callback, and waits for it,
+  // to run several infer requests from the same execution thread.
+  TRITONSERVER_Error* StartInfer(InferSlot* slot);
+  TRITONSERVER_Error* WaitInfer(InferSlot* slot);
+  // Callback of the infer request when running asynchronously.
+  void InferComplete(InferSlot* slot, std::exception_ptr exception);
+  // Splits the batch gathered into the tensors of the infer request of
+  // 'slot' into micro-batches, binding views of its rows to the tensors
+  // of the micro-batch infer requests. Leaves the batch whole if it is
+  // too small or the shape of an output is not known before inference.
+  TRITONSERVER_Error* SetMicroBatches(InferSlot* slot);
+  TRITONSERVER_Error* InferMicroBatches(InferSlot* slot);
+  void StartMicroBatches(InferSlot* slot);
+  // Accounts for 'done' micro-batches having completed, completing the
+  // execution along with the last one.
+  void MicroBatchComplete(
+      InferSlot* slot, const size_t done, std::exception_ptr exception);
   TRITONSERVER_Error* SetInputTensors(
-      size_t total_batch_size, TRITONBACKEND_Request** requests,
+      InferSlot* slot, size_t batch_size, size_t total_batch_size,
+      TRITONBACKEND_Request** requests,
       const uint32_t request_count,
+      std::vector<TRITONBACKEND_Response*>* responses);
+  // Copies the input 'name' of the requests of 'slot', one after the
+  // other, into the 'byte_size' bytes of 'buffer' holding the
+  // 'total_batch_size' rows of the batch. A request whose input can't be
+  // read, doesn't have the size of its rows, or isn't in CPU memory, is
+  // responded to with the error and its rows are skipped. The collector
+  // of the backend utilities allocates on creation, so the instance
+  // gathers the inputs it copies itself.
+  TRITONSERVER_Error* GatherInput(
+      InferSlot* slot, const char* name, const size_t total_batch_size,
+      char* buffer, const size_t byte_size);
+  // Copies the rows of each request of 'slot' from the 'byte_size' bytes
+  // of 'buffer', holding the output 'name' of the whole batch of shape
+  // 'batchn_shape', into a new output of its response if it asked for
+  // it. A response whose output can't be created in CPU memory is sent
+  // the error. 'batchn_shape' is used as scratch. The output responder
+  // of the backend utilities allocates on creation, so the instance
+  // scatters the outputs itself.
+  TRITONSERVER_Error* ScatterOutput(
+      InferSlot* slot, const char* name, const TRITONSERVER_DataType datatype,
+      std::vector<int64_t>* batchn_shape, const char* buffer,
+      const size_t byte_size);
+  // Returns in 'tensor' the request-owned tensor of the input at
+  // 'input_idx' after checking that it matches the expected element type
+  // and shape.
+  TRITONSERVER_Error* GetRequestTensor(
+      InferSlot* slot, const size_t input_idx,
+      const ov::element::Type& element_type, const ov::Shape& shape,
+      ov::Tensor** tensor);
+  // Binds 'buffer' directly as the request tensor of the input at
+  // 'input_idx' if the buffer can be used by OpenVINO as is. Returns false
+  // in 'bound' if the data must be copied into the request-owned tensor
+  // instead.
+  TRITONSERVER_Error* BindInputBuffer(
+      InferSlot* slot, const size_t input_idx,
+      const ov::element::Type& element_type, const ov::Shape& shape,
+      const char* buffer, TRITONSERVER_MemoryType memory_type, bool* bound);
+  // Allocates the response output buffers ahead of the inference and
+  // binds them as the output tensors of the infer request, recording in
+  // 'output_buffers' the buffer allocated for each output (nullptr if the
+  // output is left to the output responder).
+  TRITONSERVER_Error* BindOutputBuffers(
+      InferSlot* slot, size_t total_batch_size,
+      TRITONBACKEND_Request** requests, const uint32_t request_count,
       std::vector<TRITONBACKEND_Response*>* responses,
-      std::vector<const char*>* input_names);
+      std::vector<char*>* output_buffers);
   TRITONSERVER_Error* ReadOutputTensors(
-      size_t total_batch_size, const std::vector<const char*>& output_names,
+      InferSlot* slot, size_t batch_size, size_t total_batch_size,
+      const std::vector<char*>& output_buffers,
       TRITONBACKEND_Request** requests, const uint32_t request_count,
       std::vector<TRITONBACKEND_Response*>* responses);
+  // Zeroes the rows of the request tensor of the input at 'input_idx'
+  // from 'total_batch_size' on, which pad the batch up to the batch of
+  // the infer request.
+  void ZeroPaddingRows(
+      InferSlot* slot, const size_t input_idx, const size_t total_batch_size);
+  // Checks that the batch of the output is the batch of the infer request
+  // and trims 'output_shape' to the rows of the requests.
   TRITONSERVER_Error* ValidateOutputBatchSize(
+      const size_t batch_size, const size_t total_batch_size,
       std::vector<int64_t>* output_shape);
 
   ModelState* model_state_;
@@ -768,13 +2270,103 @@ class ModelInstanceState : public BackendModelInstance {
   std::string model_path_;
 
   std::string device_;
-
-  //changed by zhaohb
-  ov::InferRequest infer_request_;
-
-  std::map<std::string, InferenceEngine::Blob::Ptr> input_blobs_;
-
-  size_t batch_pad_size_;
+  // The NUMA node the instance is placed on, -1 if not placed, and the
+  // key of the network it runs.
+  int numa_node_;
+  std::string network_key_;
+  // The thread last restricted to the CPUs of the NUMA node, normally the
+  // thread Triton executes the instance from.
+  std::thread::id pinned_thread_;
+
+  // The metrics of the instance, null if metrics are disabled.
+  std::unique_ptr<InstanceMetrics> metrics_;
+
+  // The per-layer profile of the sampled executions since the last
+  // report, by layer name, and the time of the last report.
+  struct LayerProfile {
+    std::string node_type;
+    std::string exec_type;
+    uint64_t count;
+    uint64_t real_time_us;
+    uint64_t cpu_time_us;
+  };
+  std::mutex profile_mu_;
+  std::map<std::string, LayerProfile> layer_profiles_;
+  std::atomic<uint64_t> profiled_exec_count_;
+  uint64_t sampled_exec_count_;
+  uint64_t profile_report_ns_;
+
+  // The executions completed, for the sampling of the captured ones.
+  std::atomic<uint64_t> capture_exec_count_;
+
+  // The hardware counters of the thread executing the instance, reopened
+  // whenever Triton executes the instance from another thread, the
+  // executions started, and the counts of the sampled executions since
+  // the last report along with the time of the last report.
+  std::unique_ptr<PerfCounters> thread_perf_counters_;
+  std::thread::id perf_thread_;
+  uint64_t perf_exec_count_;
+  std::array<PerfCounts, (size_t)PerfStage::COUNT> perf_totals_;
+  uint64_t perf_sampled_count_;
+  uint64_t perf_report_ns_;
+
+  // The binding plan of the instance: the names of the inputs of the
+  // compiled network and of the outputs of the model configuration, in
+  // the order of the inputs and outputs of each BoundRequest, so that an
+  // execution refers to them by index. The output names reference the
+  // model configuration, which outlives the instance.
+  std::vector<std::string> input_names_;
+  std::vector<const char*> output_names_;
+  // The mask of all the outputs of the plan, by bit of their index, and
+  // whether executions run on networks pruned to their requested outputs,
+  // which needs the outputs to fit in the mask. The output of a pruned
+  // network is bound to no port.
+  uint64_t all_outputs_mask_;
+  bool prune_outputs_;
+  std::atomic<uint64_t> pruned_exec_count_;
+
+  // The pool of infer requests. With asynchronous execution the inputs
+  // of an execution are gathered into a free infer request while the
+  // others are running, and its outputs scattered from the callback.
+  // The mutex and condition variable are declared first, so that they
+  // outlive the infer requests whose callbacks use them.
+  std::mutex slots_mu_;
+  std::condition_variable slots_cv_;
+  std::vector<std::unique_ptr<InferSlot>> slots_;
+  std::vector<InferSlot*> free_slots_;
+  // The slots started together by ExecuteEachRequest.
+  std::vector<InferSlot*> started_slots_;
+
+  // Number of inputs bound without copy / copied into the request tensor.
+  std::atomic<uint64_t> zero_copy_input_count_;
+  std::atomic<uint64_t> copy_input_count_;
+  // Number of outputs written directly into / copied into the responses.
+  std::atomic<uint64_t> zero_copy_output_count_;
+  std::atomic<uint64_t> copy_output_count_;
+
+  // Occupancy of the pool, sampled each time an infer request is taken:
+  // the number of takes, the sum and the peak of the infer requests in
+  // use including the one taken, and the takes that had to wait for a
+  // free infer request along with the time spent waiting, summarized
+  // when the instance is unloaded. The current occupancy is exported as
+  // a gauge.
+  uint64_t slot_acquire_count_;
+  uint64_t slot_busy_sum_;
+  uint64_t slot_busy_peak_;
+  uint64_t slot_wait_count_;
+  uint64_t slot_wait_ns_;
+
+  // The number of rows of the micro-batches and the number of micro-batch
+  // infer requests of each slot, 0 if the batches are not split, and the
+  // number of executions split.
+  size_t micro_batch_size_;
+  size_t micro_request_count_;
+  std::atomic<uint64_t> micro_batch_exec_count_;
+
+  // Number of rows run by the infer requests, and among them the rows
+  // padding the batches.
+  std::atomic<uint64_t> batch_row_count_;
+  std::atomic<uint64_t> padded_row_count_;
 };
 
 TRITONSERVER_Error*
@@ -810,7 +2402,17 @@ ModelInstanceState::Create(
 ModelInstanceState::ModelInstanceState(
     ModelState* model_state, TRITONBACKEND_ModelInstance* triton_model_instance)
     : BackendModelInstance(model_state, triton_model_instance),
-      model_state_(model_state), device_("CPU"), batch_pad_size_(0)
+      model_state_(model_state), device_("CPU"), numa_node_(-1),
+      profiled_exec_count_(0), sampled_exec_count_(0), profile_report_ns_(0),
+      capture_exec_count_(0), perf_exec_count_(0), perf_sampled_count_(0),
+      perf_report_ns_(0), all_outputs_mask_(~0ULL), prune_outputs_(false),
+      pruned_exec_count_(0),
+      zero_copy_input_count_(0), copy_input_count_(0),
+      zero_copy_output_count_(0), copy_output_count_(0),
+      slot_acquire_count_(0), slot_busy_sum_(0), slot_busy_peak_(0),
+      slot_wait_count_(0), slot_wait_ns_(0), micro_batch_size_(0),
+      micro_request_count_(0), micro_batch_exec_count_(0),
+      batch_row_count_(0), padded_row_count_(0)
 {
   if (Kind() != TRITONSERVER_INSTANCEGROUPKIND_CPU) {
     throw triton::backend::BackendModelInstanceException(TRITONSERVER_ErrorNew(
@@ -827,7 +2429,28 @@ ModelInstanceState::ModelInstanceState(
     THROW_IF_BACKEND_INSTANCE_ERROR(model_state_->ValidateConfigureNetwork());
   }
 
-  if (model_state_->NetworkNotLoaded(device_)) {
+  model_state_->AssignNumaNode(&numa_node_);
+  network_key_ = ModelState::NetworkKey(device_, numa_node_);
+  if (model_state_->Metrics() != nullptr) {
+    LOG_IF_ERROR(
+        InstanceMetrics::Create(
+            model_state_->Metrics(), model_state_->Name(),
+            model_state_->Version(), Name(), numa_node_,
+            model_state_->PerfCountersInterval() > 0, &metrics_),
+        "failed to create the metrics of the model instance");
+  }
+  if (numa_node_ >= 0) {
+    const std::vector<int>& cpus = model_state_->NumaNodeCpus(numa_node_);
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("placing instance '") + Name() + "' on NUMA node " +
+         std::to_string(numa_node_) + " (" + std::to_string(cpus.size()) +
+         " CPUs from " + std::to_string(cpus.front()) + " to " +
+         std::to_string(cpus.back()) + ")")
+            .c_str());
+  }
+
+  if (model_state_->NetworkNotLoaded(network_key_)) {
     THROW_IF_BACKEND_INSTANCE_ERROR(model_state_->ParseParameters(device_));
     // enable dynamic batching in the network
     std::map<std::string, ov::AnyMap> network_config;
@@ -839,21 +2462,333 @@ ModelInstanceState::ModelInstanceState(
     //      [InferenceEngine::PluginConfigParams::KEY_DYN_BATCH_ENABLED] =
     //          InferenceEngine::PluginConfigParams::YES;
     //}
-    THROW_IF_BACKEND_INSTANCE_ERROR(model_state_->ConfigureInferenceEngine());
     THROW_IF_BACKEND_INSTANCE_ERROR(
-        model_state_->LoadNetwork(device_, network_config));
+        model_state_->LoadNetwork(device_, numa_node_, network_config));
   }
 
-  THROW_IF_BACKEND_INSTANCE_ERROR(
-      model_state_->CreateInferRequest(device_, &infer_request_));
+  THROW_IF_BACKEND_INSTANCE_ERROR(BuildBindingPlan());
 
-  THROW_IF_BACKEND_INSTANCE_ERROR(model_state_->SetNameNodeMap(&name_node_map_));
+  size_t infer_request_count;
+  THROW_IF_BACKEND_INSTANCE_ERROR(
+      model_state_->InferRequestCount(network_key_, &infer_request_count));
+  THROW_IF_BACKEND_INSTANCE_ERROR(model_state_->MicroBatchLayout(
+      network_key_, &micro_batch_size_, &micro_request_count_));
+
+  // The tensors of the infer requests are first touched, and so allocated
+  // by the kernel, on the NUMA node of the instance.
+  std::unique_ptr<ScopedThreadAffinity> numa_affinity;
+  if (numa_node_ >= 0) {
+    numa_affinity.reset(
+        new ScopedThreadAffinity(model_state_->NumaNodeCpus(numa_node_)));
+  }
+  THROW_IF_BACKEND_INSTANCE_ERROR(CreateInferSlots(infer_request_count));
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::BuildBindingPlan()
+{
+  // All the networks loaded for the batch buckets have the same inputs.
+  const std::vector<size_t>& buckets = model_state_->BatchBuckets();
+  ov::CompiledModel* compiled;
+  RETURN_IF_ERROR(model_state_->CompiledNetwork(
+      network_key_, buckets.empty() ? 0 : buckets.front(), &compiled));
+  for (const auto& input : compiled->inputs()) {
+    input_names_.push_back(
+        input.get_names().empty() ? "NONE" : input.get_any_name());
+  }
+
+  triton::common::TritonJson::Value ios;
+  RETURN_IF_ERROR(model_state_->ModelConfig().MemberAsArray("output", &ios));
+  for (size_t i = 0; i < ios.ArraySize(); i++) {
+    triton::common::TritonJson::Value io;
+    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
+    const char* io_name;
+    size_t io_name_len;
+    RETURN_IF_ERROR(io.MemberAsString("name", &io_name, &io_name_len));
+    output_names_.push_back(io_name);
+  }
+
+  prune_outputs_ = model_state_->EnableOutputPruning();
+  if (output_names_.size() < 64) {
+    all_outputs_mask_ = (1ULL << output_names_.size()) - 1;
+  } else if (output_names_.size() > 64) {
+    if (prune_outputs_) {
+      LOG_MESSAGE(
+          TRITONSERVER_LOG_WARN,
+          (std::string("model '") + model_state_->Name() + "' has " +
+           std::to_string(output_names_.size()) +
+           " outputs, more than the 64 outputs that can be pruned, "
+           "'ENABLE_OUTPUT_PRUNING' is ignored")
+              .c_str());
+    }
+    prune_outputs_ = false;
+  }
+
+  return nullptr;
+}
+
+size_t
+ModelInstanceState::InputIndex(const char* name, const size_t hint)
+{
+  // The inputs of the requests mostly come in the order of the model.
+  if ((hint < input_names_.size()) && (input_names_[hint] == name)) {
+    return hint;
+  }
+  for (size_t i = 0; i < input_names_.size(); i++) {
+    if (input_names_[i] == name) {
+      return i;
+    }
+  }
+  return input_names_.size();
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::CreateInferSlots(const size_t count)
+{
+  std::vector<size_t> buckets = model_state_->BatchBuckets();
+  if (buckets.empty()) {
+    buckets.push_back(0);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    slots_.emplace_back(new InferSlot());
+    InferSlot* slot = slots_.back().get();
+    for (const size_t bucket : buckets) {
+      BoundRequest* request = &slot->requests[bucket];
+      RETURN_IF_ERROR(model_state_->CreateInferRequest(
+          network_key_, bucket, &request->infer_request));
+      ov::CompiledModel* compiled;
+      RETURN_IF_ERROR(
+          model_state_->CompiledNetwork(network_key_, bucket, &compiled));
+      RETURN_IF_ERROR(
+          InitRequestTensors(*compiled, all_outputs_mask_, request));
+      if (model_state_->EnableAsyncExecution()) {
+        RETURN_IF_ERROR(SetInferCallback(slot, request));
+      }
+    }
+    slot->request = &slot->requests.rbegin()->second;
+    for (size_t m = 0; m < micro_request_count_; m++) {
+      slot->micro_requests.emplace_back(new BoundRequest());
+      BoundRequest* request = slot->micro_requests.back().get();
+      RETURN_IF_ERROR(model_state_->CreateInferRequest(
+          network_key_, 0, &request->infer_request));
+      ov::CompiledModel* compiled;
+      RETURN_IF_ERROR(
+          model_state_->CompiledNetwork(network_key_, 0, &compiled));
+      RETURN_IF_ERROR(
+          InitRequestTensors(*compiled, all_outputs_mask_, request));
+      if (model_state_->EnableAsyncExecution()) {
+        RETURN_IF_ERROR(SetMicroBatchCallback(slot, request));
+      }
+    }
+    free_slots_.push_back(slot);
+  }
+
+  LOG_MESSAGE(
+      TRITONSERVER_LOG_INFO,
+      (std::string("created ") + std::to_string(count) +
+       " infer request(s) for '" + Name() + "'" +
+       ((micro_request_count_ > 0)
+            ? ", each splitting its batches into up to " +
+                  std::to_string(micro_request_count_) +
+                  " micro-batches of " + std::to_string(micro_batch_size_) +
+                  " rows"
+            : std::string()))
+          .c_str());
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::InitRequestTensors(
+    const ov::CompiledModel& compiled, const uint64_t output_mask,
+    BoundRequest* request)
+{
+  // The ports of each compiled model are distinct, resolve those of the
+  // plan in the one the infer request was created from. The networks of
+  // the batch buckets and the pruned networks are derived from the same
+  // network, with the inputs in the same order.
+  const std::vector<ov::Output<const ov::Node>>& inputs = compiled.inputs();
+  RETURN_ERROR_IF_FALSE(
+      inputs.size() == input_names_.size(), TRITONSERVER_ERROR_INTERNAL,
+      std::string("unexpected inputs in a network of model '") + Name() +
+          "'");
+  request->inputs.resize(input_names_.size());
+  for (size_t idx = 0; idx < input_names_.size(); idx++) {
+    BoundTensor& input = request->inputs[idx];
+    input.port = inputs[idx];
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        input.owned, request->infer_request.get_tensor(input.port),
+        "getting request tensor for input " + input_names_[idx]);
+    input.shape = input.owned.get_shape();
+    if ((numa_node_ >= 0) && (input.owned.get_byte_size() > 0)) {
+      memset(input.owned.data(), 0, input.owned.get_byte_size());
+      input.zero_rows_from = 0;
+    }
+  }
+  request->outputs.resize(output_names_.size());
+  for (size_t idx = 0; idx < output_names_.size(); idx++) {
+    if (((output_mask >> idx) & 1) == 0) {
+      continue;
+    }
+    BoundTensor& output = request->outputs[idx];
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        output.port, compiled.output(output_names_[idx]),
+        std::string("getting port for output ") + output_names_[idx]);
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        output.owned, request->infer_request.get_tensor(output.port),
+        std::string("getting request tensor for output ") +
+            output_names_[idx]);
+    if ((numa_node_ >= 0) && (output.owned.get_byte_size() > 0)) {
+      memset(output.owned.data(), 0, output.owned.get_byte_size());
+    }
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::SetInferCallback(InferSlot* slot, BoundRequest* request)
+{
+  RETURN_IF_OPENVINO_ERROR(
+      request->infer_request.set_callback(
+          [this, slot](std::exception_ptr exception) {
+            InferComplete(slot, exception);
+          }),
+      "setting infer request callback");
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::SetMicroBatchCallback(
+    InferSlot* slot, BoundRequest* request)
+{
+  RETURN_IF_OPENVINO_ERROR(
+      request->infer_request.set_callback(
+          [this, slot](std::exception_ptr exception) {
+            MicroBatchComplete(slot, 1, exception);
+          }),
+      "setting micro-batch infer request callback");
+
+  return nullptr;
+}
+
+ModelInstanceState::InferSlot*
+ModelInstanceState::AcquireSlot()
+{
+  std::unique_lock<std::mutex> lock(slots_mu_);
+  if (free_slots_.empty()) {
+    uint64_t wait_start_ns = 0;
+    SET_TIMESTAMP(wait_start_ns);
+    slots_cv_.wait(lock, [this] { return !free_slots_.empty(); });
+    uint64_t wait_end_ns = 0;
+    SET_TIMESTAMP(wait_end_ns);
+    slot_wait_count_++;
+    slot_wait_ns_ += wait_end_ns - wait_start_ns;
+    if (metrics_ != nullptr) {
+      metrics_->ObservePoolWait(wait_end_ns - wait_start_ns);
+    }
+  }
+
+  InferSlot* slot = free_slots_.back();
+  free_slots_.pop_back();
+
+  const uint64_t busy = slots_.size() - free_slots_.size();
+  slot_acquire_count_++;
+  slot_busy_sum_ += busy;
+  slot_busy_peak_ = std::max(slot_busy_peak_, busy);
+  if (metrics_ != nullptr) {
+    metrics_->SetPoolInUse(busy);
+  }
+
+  return slot;
+}
+
+void
+ModelInstanceState::ReleaseSlot(InferSlot* slot)
+{
+  // Notified under the lock: once the pool is full the destructor may
+  // return, so the callback must not touch the instance after unlocking.
+  std::lock_guard<std::mutex> lock(slots_mu_);
+  free_slots_.push_back(slot);
+  if (metrics_ != nullptr) {
+    metrics_->SetPoolInUse(slots_.size() - free_slots_.size());
+  }
+  slots_cv_.notify_all();
+}
+
+void
+ModelInstanceState::WaitForCompletion()
+{
+  std::unique_lock<std::mutex> lock(slots_mu_);
+  slots_cv_.wait(
+      lock, [this] { return free_slots_.size() == slots_.size(); });
 }
 
 ModelInstanceState::~ModelInstanceState()
 {
-  for (auto itr : input_blobs_) {
-    itr.second->deallocate();
+  // Let the asynchronous executions in flight, if any, send their
+  // responses.
+  WaitForCompletion();
+
+  {
+    std::lock_guard<std::mutex> lock(profile_mu_);
+    LOG_IF_ERROR(ReportProfile(), "failed to report the per-layer profile");
+  }
+  ReportPerfCounts();
+
+  if (model_state_->EnableZeroCopyInput()) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("input binding for '") + Name() +
+         "': " + std::to_string(zero_copy_input_count_) + " zero-copy, " +
+         std::to_string(copy_input_count_) + " copied")
+            .c_str());
+  }
+  if (model_state_->EnableZeroCopyOutput()) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("output binding for '") + Name() +
+         "': " + std::to_string(zero_copy_output_count_) + " zero-copy, " +
+         std::to_string(copy_output_count_) + " copied")
+            .c_str());
+  }
+  if (pruned_exec_count_ > 0) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("output pruning of '") + Name() + "': " +
+         std::to_string(pruned_exec_count_) +
+         " executions run on pruned networks")
+            .c_str());
+  }
+  if (micro_batch_exec_count_ > 0) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("micro-batching of '") + Name() + "': " +
+         std::to_string(micro_batch_exec_count_) +
+         " executions split into micro-batches")
+            .c_str());
+  }
+  if (padded_row_count_ > 0) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("batch padding for '") + Name() + "': " +
+         std::to_string(padded_row_count_) + " padded rows out of " +
+         std::to_string(batch_row_count_) + " rows run")
+            .c_str());
+  }
+  if (slot_acquire_count_ > 0) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("infer request pool of '") + Name() + "': " +
+         std::to_string(slots_.size()) + " request(s), average " +
+         std::to_string((double)slot_busy_sum_ / slot_acquire_count_) +
+         " and peak " + std::to_string(slot_busy_peak_) + " in use over " +
+         std::to_string(slot_acquire_count_) + " executions, " +
+         std::to_string(slot_wait_count_) + " waited for " +
+         std::to_string(slot_wait_ns_ / 1000) + " us")
+            .c_str());
   }
 }
 
@@ -861,21 +2796,26 @@ void
 ModelInstanceState::ProcessRequests(
     TRITONBACKEND_Request** requests, const uint32_t request_count)
 {
-  LOG_MESSAGE(
-      TRITONSERVER_LOG_VERBOSE,
-      (std::string("TRITONBACKEND_ModelExecute: Running ") + Name() + " with " +
-       std::to_string(request_count) + " requests")
-          .c_str());
+  if (TRITONSERVER_LogIsEnabled(TRITONSERVER_LOG_VERBOSE)) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_VERBOSE,
+        (std::string("TRITONBACKEND_ModelExecute: Running ") + Name() +
+         " with " + std::to_string(request_count) + " requests")
+            .c_str());
+  }
 
   uint64_t exec_start_ns = 0;
   SET_TIMESTAMP(exec_start_ns);
 
-  const int max_batch_size = model_state_->MaxBatchSize();
+  // The staging buffers of the inputs are first touched by the thread
+  // gathering into them, which must then run on the NUMA node too.
+  if ((numa_node_ >= 0) && (std::this_thread::get_id() != pinned_thread_)) {
+    LOG_IF_ERROR(
+        SetThreadAffinity(model_state_->NumaNodeCpus(numa_node_)),
+        "failed to place the execution on its NUMA node");
+    pinned_thread_ = std::this_thread::get_id();
+  }
 
-  // For each request collect the total batch size for this inference
-  // execution. The batch-size, number of inputs, and size of each
-  // input has already been checked so don't need to do that here.
-  size_t total_batch_size = 0;
   for (size_t i = 0; i < request_count; i++) {
     // If we get a nullptr request then something is badly wrong. Fail
     // and release all requests.
@@ -891,6 +2831,200 @@ ModelInstanceState::ProcessRequests(
     }
   }
 
+  // Without batching the inputs of the requests can't be gathered into
+  // the same tensors, so each request runs on an infer request of its own.
+  if ((model_state_->MaxBatchSize() == 0) && (request_count > 1)) {
+    ExecuteEachRequest(requests, request_count, exec_start_ns);
+  } else if (model_state_->HasVariableDims() && (request_count > 1)) {
+    // Requests whose inputs differ in shape can't be gathered into the
+    // same tensors, so each group of requests with the same shapes is run
+    // as its own execution, concurrently when executing asynchronously.
+    std::vector<std::vector<TRITONBACKEND_Request*>> groups;
+    GroupRequestsByShape(requests, request_count, &groups);
+    for (auto& group : groups) {
+      ExecuteRequests(group.data(), group.size(), exec_start_ns);
+    }
+  } else {
+    ExecuteRequests(requests, request_count, exec_start_ns);
+  }
+}
+
+void
+ModelInstanceState::GroupRequestsByShape(
+    TRITONBACKEND_Request** requests, const uint32_t request_count,
+    std::vector<std::vector<TRITONBACKEND_Request*>>* groups)
+{
+  const bool batching = (model_state_->MaxBatchSize() > 0);
+
+  // The shapes of the inputs of each group, by input name.
+  std::vector<std::map<std::string, std::vector<int64_t>>> group_shapes;
+  for (uint32_t r = 0; r < request_count; r++) {
+    std::map<std::string, std::vector<int64_t>> shapes;
+    uint32_t input_count = 0;
+    TRITONSERVER_Error* err =
+        TRITONBACKEND_RequestInputCount(requests[r], &input_count);
+    for (uint32_t i = 0; (err == nullptr) && (i < input_count); i++) {
+      TRITONBACKEND_Input* input;
+      err = TRITONBACKEND_RequestInputByIndex(requests[r], i, &input);
+      if (err == nullptr) {
+        const char* name;
+        const int64_t* shape;
+        uint32_t dims_count;
+        err = TRITONBACKEND_InputProperties(
+            input, &name, nullptr, &shape, &dims_count, nullptr, nullptr);
+        if (err == nullptr) {
+          const size_t skip = (batching && (dims_count > 0)) ? 1 : 0;
+          shapes[name].assign(shape + skip, shape + dims_count);
+        }
+      }
+    }
+
+    // A request whose inputs can't be read is run alone, its execution
+    // then responds with the error.
+    size_t g = 0;
+    if (err != nullptr) {
+      TRITONSERVER_ErrorDelete(err);
+      g = groups->size();
+    } else {
+      while ((g < group_shapes.size()) && (group_shapes[g] != shapes)) {
+        g++;
+      }
+    }
+    if (g == groups->size()) {
+      groups->emplace_back();
+      group_shapes.emplace_back(std::move(shapes));
+    }
+    (*groups)[g].push_back(requests[r]);
+  }
+}
+
+void
+ModelInstanceState::ExecuteRequests(
+    TRITONBACKEND_Request** requests, const uint32_t request_count,
+    const uint64_t exec_start_ns)
+{
+  // An infer request and its payload can only be used by one execution
+  // at a time, wait for one to be released by the previous executions.
+  uint64_t acquire_start_ns = 0;
+  SET_TIMESTAMP(acquire_start_ns);
+  InferSlot* slot = AcquireSlot();
+
+  Payload* payload = &slot->payload;
+  payload->requests.assign(requests, requests + request_count);
+  payload->exec_start_ns = exec_start_ns;
+  payload->acquire_start_ns = acquire_start_ns;
+
+  // If there are no valid payloads then no need to run the inference.
+  if (!PrepareExecution(slot)) {
+    ReleaseSlot(slot);
+    return;
+  }
+
+  ReadPerfCounters(slot, PerfStage::INPUTS, true /* end */);
+  ReadPerfCounters(slot, PerfStage::INFER, false /* end */);
+  SET_TIMESTAMP(payload->compute_start_ns);
+
+  // Run...
+  if (!payload->all_response_failed) {
+    if (model_state_->EnableAsyncExecution()) {
+      // The execution is completed, and the infer request released, by
+      // the callback of the infer request.
+      TRITONSERVER_Error* err = InferAsync(slot);
+      if (err == nullptr) {
+        return;
+      }
+      RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+          payload->responses, request_count, payload->all_response_failed,
+          err);
+    } else {
+      RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+          payload->responses, request_count, payload->all_response_failed,
+          Infer(slot, &payload->responses, request_count));
+    }
+  }
+
+  SET_TIMESTAMP(payload->compute_end_ns);
+  ReadPerfCounters(slot, PerfStage::INFER, true /* end */);
+  ReadPerfCounters(slot, PerfStage::OUTPUTS, false /* end */);
+
+  CompleteExecution(slot);
+  ReleaseSlot(slot);
+}
+
+void
+ModelInstanceState::ExecuteEachRequest(
+    TRITONBACKEND_Request** requests, const uint32_t request_count,
+    const uint64_t exec_start_ns)
+{
+  // The callbacks of the infer requests complete the executions already.
+  if (model_state_->EnableAsyncExecution()) {
+    for (uint32_t r = 0; r < request_count; r++) {
+      ExecuteRequests(&requests[r], 1, exec_start_ns);
+    }
+    return;
+  }
+
+  // Otherwise start the inference of as many requests as there are infer
+  // requests in the pool, then wait for all of them before the next ones.
+  const uint32_t wave_size = std::max<size_t>(SlotCount(), 1);
+  std::vector<InferSlot*>& started = started_slots_;
+  for (uint32_t begin = 0; begin < request_count; begin += wave_size) {
+    const uint32_t end = std::min(begin + wave_size, request_count);
+    started.clear();
+    for (uint32_t r = begin; r < end; r++) {
+      uint64_t acquire_start_ns = 0;
+      SET_TIMESTAMP(acquire_start_ns);
+      InferSlot* slot = AcquireSlot();
+      Payload* payload = &slot->payload;
+      payload->requests.assign(&requests[r], &requests[r] + 1);
+      payload->exec_start_ns = exec_start_ns;
+      payload->acquire_start_ns = acquire_start_ns;
+      if (!PrepareExecution(slot)) {
+        ReleaseSlot(slot);
+        continue;
+      }
+
+      ReadPerfCounters(slot, PerfStage::INPUTS, true /* end */);
+      ReadPerfCounters(slot, PerfStage::INFER, false /* end */);
+      SET_TIMESTAMP(payload->compute_start_ns);
+      if (!payload->all_response_failed) {
+        RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+            payload->responses, 1, payload->all_response_failed,
+            StartInfer(slot));
+      }
+      started.push_back(slot);
+    }
+
+    for (InferSlot* slot : started) {
+      Payload* payload = &slot->payload;
+      if (!payload->all_response_failed) {
+        RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+            payload->responses, 1, payload->all_response_failed,
+            WaitInfer(slot));
+      }
+      SET_TIMESTAMP(payload->compute_end_ns);
+      ReadPerfCounters(slot, PerfStage::INFER, true /* end */);
+      ReadPerfCounters(slot, PerfStage::OUTPUTS, false /* end */);
+
+      CompleteExecution(slot);
+      ReleaseSlot(slot);
+    }
+  }
+}
+
+bool
+ModelInstanceState::PrepareExecution(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  TRITONBACKEND_Request** requests = payload->requests.data();
+  const uint32_t request_count = payload->requests.size();
+  std::vector<TRITONBACKEND_Response*>& responses = payload->responses;
+  bool& all_response_failed = payload->all_response_failed;
+
+  const int max_batch_size = model_state_->MaxBatchSize();
+  SET_TIMESTAMP(payload->prepare_start_ns);
+  StartPerfSample(slot);
+
   // At this point we are committed to running inference with all
   // 'requests'. Create a response for each request. During input
   // processing if there is an error with any request that error will
@@ -902,9 +3036,9 @@ ModelInstanceState::ProcessRequests(
   // need the outputs for a request that has an error, we do need to
   // know the size of those outputs associated with the request so we
   // can skip them in the output tensors).
-  std::vector<TRITONBACKEND_Response*> responses;
+  responses.clear();
   responses.reserve(request_count);
-  bool all_response_failed = false;
+  all_response_failed = false;
 
   for (size_t i = 0; i < request_count; i++) {
     TRITONBACKEND_Response* response;
@@ -918,6 +3052,10 @@ ModelInstanceState::ProcessRequests(
     }
   }
 
+  // For each request collect the total batch size for this inference
+  // execution. The batch-size, number of inputs, and size of each
+  // input has already been checked so don't need to do that here.
+  size_t total_batch_size = 0;
   for (size_t i = 0; i < request_count; i++) {
     if (max_batch_size > 0) {
       // Retrieve the batch size from one of the inputs, if the model
@@ -935,35 +3073,15 @@ ModelInstanceState::ProcessRequests(
         RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
             responses, request_count, all_response_failed, err);
       }
-      if (!all_response_failed) {
-        if (total_batch_size != (size_t)max_batch_size) {
-          if (model_state_->EnableBatchPadding()) {
-            batch_pad_size_ = max_batch_size - total_batch_size;
-          } else {
-            RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
-                responses, request_count, all_response_failed,
-                TRITONSERVER_ErrorNew(
-                    TRITONSERVER_ERROR_INTERNAL,
-                    std::string(
-                        "expected requests with batch size '" +
-                        std::to_string(max_batch_size) + "', got '" +
-                        std::to_string(total_batch_size) +
-                        "'... this error can be avoided by setting "
-                        "'ENABLE_BATCH_PADDING' parameter in model "
-                        "configuration "
-                        "to 'YES' at a performance cost.")
-                        .c_str()));
-          }
-        }
-      }
     } else {
       total_batch_size += 1;
     }
   }
+  payload->total_batch_size = total_batch_size;
 
   // If there are no valid payloads then no need to run the inference.
   if (total_batch_size == 0) {
-    return;
+    return false;
   }
 
   // Make sure the maximum batch size is not exceeded. The
@@ -986,143 +3104,1007 @@ ModelInstanceState::ProcessRequests(
     }
   }
 
+  // Only the outputs asked for by the requests are retrieved, in the
+  // order of the plan.
+  if (!all_response_failed) {
+    RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+        responses, request_count, all_response_failed,
+        SetRequestedOutputs(slot));
+  }
+
+  // Run on the infer request of the smallest batch bucket that fits the
+  // batch, or with a static batch of max_batch_size if the batch is not
+  // dynamic. The rows above the batch are padding whose outputs are
+  // dropped.
+  const std::vector<size_t>& buckets = model_state_->BatchBuckets();
+  payload->batch_size = total_batch_size;
+  if (buckets.empty()) {
+    slot->request = &slot->requests[0];
+    if (prune_outputs_ && !all_response_failed) {
+      RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+          responses, request_count, all_response_failed,
+          SelectPrunedRequest(slot));
+    }
+    if ((max_batch_size > 0) && model_state_->SkipDynamicBatchSize() &&
+        (total_batch_size != (size_t)max_batch_size) &&
+        !all_response_failed) {
+      if (model_state_->EnableBatchPadding()) {
+        payload->batch_size = max_batch_size;
+      } else {
+        RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+            responses, request_count, all_response_failed,
+            TRITONSERVER_ErrorNew(
+                TRITONSERVER_ERROR_INTERNAL,
+                std::string(
+                    "expected requests with batch size '" +
+                    std::to_string(max_batch_size) + "', got '" +
+                    std::to_string(total_batch_size) +
+                    "'... this error can be avoided by setting "
+                    "'ENABLE_BATCH_PADDING' parameter in model "
+                    "configuration "
+                    "to 'YES' at a performance cost.")
+                    .c_str()));
+      }
+    }
+  } else {
+    auto bit =
+        std::lower_bound(buckets.begin(), buckets.end(), total_batch_size);
+    payload->batch_size = (bit != buckets.end()) ? *bit : buckets.back();
+    slot->request = &slot->requests[payload->batch_size];
+  }
+  if (!all_response_failed) {
+    batch_row_count_ += payload->batch_size;
+    padded_row_count_ += payload->batch_size - total_batch_size;
+    if (metrics_ != nullptr) {
+      metrics_->ObserveRows(
+          payload->batch_size, payload->batch_size - total_batch_size);
+    }
+  }
+
   if (!all_response_failed) {
-    if (!model_state_->SkipDynamicBatchSize()) {
+    if (!model_state_->SkipDynamicBatchSize() && buckets.empty()) {
       // Sets the new batch size before issuing the inference.
       if (max_batch_size != 0) {
         RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
             responses, request_count, all_response_failed,
-            SetBatch(total_batch_size));
+            SetBatch(slot, total_batch_size));
       }
     }
   }
 
-  std::vector<const char*> input_names;
-  if (!all_response_failed) {
+  if (!all_response_failed) {
+    RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+        responses, request_count, all_response_failed,
+        SetInputTensors(
+            slot, payload->batch_size, total_batch_size, requests,
+            request_count, &responses));
+  }
+
+  payload->output_buffers.assign(output_names_.size(), nullptr);
+  if (!all_response_failed && model_state_->EnableZeroCopyOutput()) {
+    RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+        responses, request_count, all_response_failed,
+        BindOutputBuffers(
+            slot, total_batch_size, requests, request_count, &responses,
+            &payload->output_buffers));
+  }
+
+  payload->micro_batch_count = 0;
+  if (!all_response_failed && (micro_request_count_ > 0)) {
+    RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+        responses, request_count, all_response_failed,
+        SetMicroBatches(slot));
+  }
+
+  return true;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::SelectPrunedRequest(InferSlot* slot)
+{
+  uint64_t output_mask = 0;
+  const std::vector<bool>& requested_outputs = slot->payload.requested_outputs;
+  for (size_t idx = 0; idx < requested_outputs.size(); idx++) {
+    if (requested_outputs[idx]) {
+      output_mask |= 1ULL << idx;
+    }
+  }
+  if ((output_mask == 0) || (output_mask == all_outputs_mask_)) {
+    return nullptr;
+  }
+
+  // The whole network runs until the pruned one is compiled.
+  std::shared_ptr<ov::CompiledModel> compiled;
+  RETURN_IF_ERROR(model_state_->PrunedNetwork(
+      network_key_, output_mask, output_names_, &compiled));
+  if (compiled == nullptr) {
+    return nullptr;
+  }
+
+  auto it = slot->pruned_requests.find(output_mask);
+  if (it == slot->pruned_requests.end()) {
+    // A slot keeps no more pruned infer requests than the model keeps
+    // pruned networks, those left from evicted networks go first.
+    if (slot->pruned_requests.size() >= model_state_->MaxPrunedVariants()) {
+      slot->pruned_requests.clear();
+    }
+
+    BoundRequest request;
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        request.infer_request, compiled->create_infer_request(),
+        "creating pruned infer request");
+    RETURN_IF_ERROR(InitRequestTensors(*compiled, output_mask, &request));
+    it = slot->pruned_requests.emplace(output_mask, std::move(request)).first;
+    if (model_state_->EnableAsyncExecution()) {
+      TRITONSERVER_Error* err = SetInferCallback(slot, &it->second);
+      if (err != nullptr) {
+        slot->pruned_requests.erase(it);
+        return err;
+      }
+    }
+  }
+
+  slot->request = &it->second;
+  pruned_exec_count_++;
+
+  return nullptr;
+}
+
+void
+ModelInstanceState::SampleProfile(InferSlot* slot)
+{
+  if ((profiled_exec_count_++ % model_state_->ProfilingInterval()) != 0) {
+    return;
+  }
+
+  // The first micro-batch stands for all of them.
+  ov::InferRequest& infer_request =
+      (slot->payload.micro_batch_count > 0)
+          ? slot->micro_requests[0]->infer_request
+          : slot->request->infer_request;
+  std::vector<ov::ProfilingInfo> profiling_info;
+  try {
+    profiling_info = infer_request.get_profiling_info();
+  }
+  catch (const std::exception& error) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_ERROR,
+        (std::string("openvino error in reading the profile of '") + Name() +
+         "' : " + error.what())
+            .c_str());
+    return;
+  }
+
+  uint64_t now_ns = 0;
+  SET_TIMESTAMP(now_ns);
+  std::lock_guard<std::mutex> lock(profile_mu_);
+  for (const auto& info : profiling_info) {
+    if (info.status != ov::ProfilingInfo::Status::EXECUTED) {
+      continue;
+    }
+    auto it = layer_profiles_.find(info.node_name);
+    if (it == layer_profiles_.end()) {
+      it = layer_profiles_
+               .emplace(
+                   info.node_name,
+                   LayerProfile{info.node_type, info.exec_type, 0, 0, 0})
+               .first;
+    }
+    it->second.count++;
+    it->second.real_time_us += info.real_time.count();
+    it->second.cpu_time_us += info.cpu_time.count();
+  }
+  sampled_exec_count_++;
+
+  if (profile_report_ns_ == 0) {
+    profile_report_ns_ = now_ns;
+  } else if (
+      (now_ns - profile_report_ns_) >=
+      model_state_->ProfilingReportSec() * 1000000000ULL) {
+    LOG_IF_ERROR(ReportProfile(), "failed to report the per-layer profile");
+    profile_report_ns_ = now_ns;
+  }
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::ReportProfile()
+{
+  if (sampled_exec_count_ == 0) {
+    return nullptr;
+  }
+
+  std::vector<std::pair<const std::string*, const LayerProfile*>> layers;
+  for (const auto& item : layer_profiles_) {
+    layers.emplace_back(&item.first, &item.second);
+  }
+  std::sort(
+      layers.begin(), layers.end(),
+      [](const std::pair<const std::string*, const LayerProfile*>& a,
+         const std::pair<const std::string*, const LayerProfile*>& b) {
+        return a.second->real_time_us > b.second->real_time_us;
+      });
+  layers.resize(std::min(layers.size(), model_state_->ProfilingTopLayers()));
+
+  triton::common::TritonJson::Value report(
+      triton::common::TritonJson::ValueType::OBJECT);
+  RETURN_IF_ERROR(report.AddString("model", model_state_->Name()));
+  RETURN_IF_ERROR(report.AddUInt("version", model_state_->Version()));
+  RETURN_IF_ERROR(report.AddString("instance", Name()));
+  RETURN_IF_ERROR(report.AddUInt("sampled_executions", sampled_exec_count_));
+  triton::common::TritonJson::Value layers_json(
+      report, triton::common::TritonJson::ValueType::ARRAY);
+  for (const auto& layer : layers) {
+    triton::common::TritonJson::Value layer_json(
+        report, triton::common::TritonJson::ValueType::OBJECT);
+    RETURN_IF_ERROR(layer_json.AddString("name", *layer.first));
+    RETURN_IF_ERROR(layer_json.AddString("type", layer.second->node_type));
+    RETURN_IF_ERROR(
+        layer_json.AddString("exec_type", layer.second->exec_type));
+    RETURN_IF_ERROR(layer_json.AddUInt("count", layer.second->count));
+    RETURN_IF_ERROR(
+        layer_json.AddUInt("real_time_us", layer.second->real_time_us));
+    RETURN_IF_ERROR(
+        layer_json.AddUInt("cpu_time_us", layer.second->cpu_time_us));
+    RETURN_IF_ERROR(layer_json.AddDouble(
+        "average_real_time_us",
+        (double)layer.second->real_time_us / layer.second->count));
+    RETURN_IF_ERROR(layers_json.Append(std::move(layer_json)));
+  }
+  RETURN_IF_ERROR(report.Add("layers", std::move(layers_json)));
+
+  triton::common::TritonJson::WriteBuffer buffer;
+  RETURN_IF_ERROR(report.Write(&buffer));
+
+  // Each report starts over, so that it shows the recent executions.
+  layer_profiles_.clear();
+  sampled_exec_count_ = 0;
+
+  const std::string& output = model_state_->ProfilingOutput();
+  if (output.empty()) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_INFO,
+        (std::string("per-layer profile: ") + buffer.Contents()).c_str());
+    return nullptr;
+  }
+
+  std::ofstream file(output, std::ios::app);
+  file << buffer.Contents() << std::endl;
+  if (!file) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("failed to write the per-layer profile to '") + output +
+         "'")
+            .c_str());
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::SetLatencyParameters(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  auto duration_us = [](const uint64_t start_ns, const uint64_t end_ns) {
+    return (int64_t)((end_ns > start_ns) ? (end_ns - start_ns) / 1000 : 0);
+  };
+  // The time spent in the queue of the scheduler is not known to the
+  // backend. The wait for the infer request is that of this execution
+  // alone, not of the earlier executions the requests handed over by
+  // Triton were split into.
+  const std::pair<const char*, int64_t> parameters[] = {
+      {"openvino_pool_wait_us",
+       duration_us(payload->acquire_start_ns, payload->prepare_start_ns)},
+      {"openvino_gather_inputs_us",
+       duration_us(payload->prepare_start_ns, payload->inputs_gathered_ns)},
+      {"openvino_copy_inputs_us",
+       duration_us(payload->inputs_gathered_ns, payload->inputs_copied_ns)},
+      {"openvino_infer_us",
+       duration_us(payload->compute_start_ns, payload->compute_end_ns)},
+      {"openvino_scatter_outputs_us",
+       duration_us(payload->compute_end_ns, payload->outputs_scattered_ns)},
+      {"openvino_request_count", (int64_t)payload->requests.size()},
+      {"openvino_batch_size", (int64_t)payload->batch_size},
+      {"openvino_padded_rows",
+       (int64_t)(payload->batch_size - payload->total_batch_size)}};
+
+  TRITONSERVER_Error* first_err = nullptr;
+  for (TRITONBACKEND_Response* response : payload->responses) {
+    if (response == nullptr) {
+      continue;
+    }
+    for (const auto& parameter : parameters) {
+      TRITONSERVER_Error* err = TRITONBACKEND_ResponseSetIntParameter(
+          response, parameter.first, parameter.second);
+      if (err == nullptr) {
+        continue;
+      }
+      if (first_err == nullptr) {
+        first_err = err;
+      } else {
+        TRITONSERVER_ErrorDelete(err);
+      }
+    }
+  }
+
+  return first_err;
+}
+
+void
+ModelInstanceState::StartPerfSample(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  const size_t interval = model_state_->PerfCountersInterval();
+  payload->perf_sampled =
+      (interval > 0) && ((perf_exec_count_++ % interval) == 0);
+  if (!payload->perf_sampled) {
+    return;
+  }
+
+  if ((thread_perf_counters_ == nullptr) ||
+      (perf_thread_ != std::this_thread::get_id())) {
+    thread_perf_counters_.reset();
+    TRITONSERVER_Error* err =
+        PerfCounters::CreateForThread(&thread_perf_counters_);
+    if (err != nullptr) {
+      payload->perf_sampled = false;
+      LOG_IF_ERROR(err, "failed to open the hardware counters");
+      return;
+    }
+    perf_thread_ = std::this_thread::get_id();
+  }
+  ReadPerfCounters(slot, PerfStage::INPUTS, false /* end */);
+}
+
+void
+ModelInstanceState::ReadPerfCounters(
+    InferSlot* slot, const PerfStage stage, const bool end)
+{
+  Payload* payload = &slot->payload;
+  if (!payload->perf_sampled) {
+    return;
+  }
+
+  TRITONSERVER_Error* err = nullptr;
+  if (stage == PerfStage::INFER) {
+    // The window of the process counts the overlapping inferences of all
+    // the instances once, and its counts are since the window opened.
+    PerfWindow* window = model_state_->ProcessPerfWindow();
+    if (end) {
+      err = window->Leave(&payload->perf_end[(size_t)stage]);
+    } else {
+      payload->perf_start[(size_t)stage].fill(0);
+      err = window->Enter();
+    }
+  } else {
+    err = thread_perf_counters_->Read(
+        end ? &payload->perf_end[(size_t)stage]
+            : &payload->perf_start[(size_t)stage]);
+  }
+  if (err != nullptr) {
+    payload->perf_sampled = false;
+    LOG_IF_ERROR(err, "failed to read the hardware counters");
+  }
+}
+
+void
+ModelInstanceState::ObservePerfCounts(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  std::array<PerfCounts, (size_t)PerfStage::COUNT> counts;
+  for (size_t stage = 0; stage < counts.size(); stage++) {
+    for (size_t counter = 0; counter < counts[stage].size(); counter++) {
+      const uint64_t start = payload->perf_start[stage][counter];
+      const uint64_t end = payload->perf_end[stage][counter];
+      // The scaled counts of multiplexed counters may go slightly back.
+      counts[stage][counter] = (end > start) ? end - start : 0;
+    }
+  }
+  if (metrics_ != nullptr) {
+    metrics_->ObservePerfCounts(counts);
+  }
+  // The counts of the inference are those of the whole process, which
+  // the instance can't claim.
+  if (model_state_->ProcessMetrics() != nullptr) {
+    model_state_->ProcessMetrics()->ObservePerfCounts(
+        counts[(size_t)PerfStage::INFER]);
+  }
+
+  if (perf_sampled_count_ == 0) {
+    for (auto& stage_counts : perf_totals_) {
+      stage_counts.fill(0);
+    }
+  }
+  for (size_t stage = 0; stage < counts.size(); stage++) {
+    if (stage == (size_t)PerfStage::INFER) {
+      continue;
+    }
+    for (size_t counter = 0; counter < counts[stage].size(); counter++) {
+      perf_totals_[stage][counter] += counts[stage][counter];
+    }
+  }
+  perf_sampled_count_++;
+
+  const size_t report_sec = model_state_->PerfCountersReportSec();
+  if (report_sec == 0) {
+    return;
+  }
+  if (perf_report_ns_ == 0) {
+    perf_report_ns_ = payload->outputs_scattered_ns;
+  } else if (
+      (payload->outputs_scattered_ns - perf_report_ns_) >=
+      report_sec * 1000000000ULL) {
+    ReportPerfCounts();
+    perf_report_ns_ = payload->outputs_scattered_ns;
+  }
+}
+
+void
+ModelInstanceState::ReportPerfCounts()
+{
+  if (perf_sampled_count_ == 0) {
+    return;
+  }
+
+  std::string report;
+  for (size_t stage = 0; stage < perf_totals_.size(); stage++) {
+    if (stage == (size_t)PerfStage::INFER) {
+      continue;
+    }
+    const PerfCounts& totals = perf_totals_[stage];
+    const double instructions = totals[(size_t)PerfCounter::INSTRUCTIONS];
+    const double cycles = totals[(size_t)PerfCounter::CYCLES];
+    const double llc_misses = totals[(size_t)PerfCounter::LLC_MISSES];
+    std::stringstream ss;
+    ss << (report.empty() ? "" : "; ") << PerfStageName((PerfStage)stage)
+       << ": " << (cycles / perf_sampled_count_) << " cycles, "
+       << (instructions / perf_sampled_count_) << " instructions, IPC "
+       << ((cycles > 0) ? instructions / cycles : 0) << ", "
+       << ((instructions > 0) ? llc_misses * 1000 / instructions : 0)
+       << " LLC misses per 1000 instructions, "
+       << ((double)totals[(size_t)PerfCounter::CONTEXT_SWITCHES] /
+           perf_sampled_count_)
+       << " context switches";
+    report += ss.str();
+  }
+  LOG_MESSAGE(
+      TRITONSERVER_LOG_INFO,
+      (std::string("hardware counters of '") + Name() +
+       "' per execution over " + std::to_string(perf_sampled_count_) +
+       " sampled executions: " + report)
+          .c_str());
+
+  // Each report starts over, so that it shows the recent executions.
+  perf_sampled_count_ = 0;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::CaptureExecution(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  const size_t interval = model_state_->CaptureInterval();
+  const uint64_t threshold_ns =
+      model_state_->CaptureLatencyThresholdUs() * 1000ULL;
+  bool capture = (interval > 0) && ((capture_exec_count_++ % interval) == 0);
+  capture |= (threshold_ns > 0) && ((payload->outputs_scattered_ns -
+                                     payload->exec_start_ns) >= threshold_ns);
+  if (!capture) {
+    return nullptr;
+  }
+
+  TraceExecution execution;
+  execution.start_ns = payload->exec_start_ns;
+  execution.end_ns = payload->outputs_scattered_ns;
+  execution.instance = Name();
+  execution.requests.resize(payload->requests.size());
+  for (size_t r = 0; r < payload->requests.size(); r++) {
+    TRITONBACKEND_Request* request = payload->requests[r];
+    TraceRequest& trace_request = execution.requests[r];
+
+    uint32_t input_count;
+    RETURN_IF_ERROR(TRITONBACKEND_RequestInputCount(request, &input_count));
+    trace_request.inputs.resize(input_count);
+    for (uint32_t i = 0; i < input_count; i++) {
+      TraceInput& trace_input = trace_request.inputs[i];
+      TRITONBACKEND_Input* input;
+      RETURN_IF_ERROR(TRITONBACKEND_RequestInputByIndex(request, i, &input));
+      const char* name;
+      const int64_t* shape;
+      uint32_t dims_count;
+      uint64_t byte_size;
+      uint32_t buffer_count;
+      RETURN_IF_ERROR(TRITONBACKEND_InputProperties(
+          input, &name, &trace_input.datatype, &shape, &dims_count,
+          &byte_size, &buffer_count));
+      trace_input.name = name;
+      trace_input.shape.assign(shape, shape + dims_count);
+      if (!model_state_->CaptureInputs()) {
+        continue;
+      }
+
+      trace_input.data.reserve(byte_size);
+      for (uint32_t b = 0; b < buffer_count; b++) {
+        const void* buffer;
+        uint64_t buffer_byte_size;
+        TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+        int64_t memory_type_id = 0;
+        RETURN_IF_ERROR(TRITONBACKEND_InputBuffer(
+            input, b, &buffer, &buffer_byte_size, &memory_type,
+            &memory_type_id));
+        if (memory_type == TRITONSERVER_MEMORY_GPU) {
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_UNSUPPORTED,
+              (std::string("unable to capture the input '") + name +
+               "' in GPU memory")
+                  .c_str());
+        }
+        const char* data = reinterpret_cast<const char*>(buffer);
+        trace_input.data.insert(
+            trace_input.data.end(), data, data + buffer_byte_size);
+      }
+    }
+
+    uint32_t output_count;
+    RETURN_IF_ERROR(TRITONBACKEND_RequestOutputCount(request, &output_count));
+    for (uint32_t o = 0; o < output_count; o++) {
+      const char* name;
+      RETURN_IF_ERROR(TRITONBACKEND_RequestOutputName(request, o, &name));
+      trace_request.requested_outputs.push_back(name);
+    }
+  }
+
+  return model_state_->CaptureTrace()->Write(execution);
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::SetRequestedOutputs(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  std::vector<bool>& requested_outputs = payload->requested_outputs;
+  requested_outputs.assign(output_names_.size(), false);
+
+  size_t requested_count = 0;
+  for (size_t r = 0; (r < payload->requests.size()) &&
+                     (requested_count < requested_outputs.size());
+       r++) {
+    // A request that failed already has no response to fill.
+    if (payload->responses[r] == nullptr) {
+      continue;
+    }
+
+    uint32_t output_count;
+    RETURN_IF_ERROR(
+        TRITONBACKEND_RequestOutputCount(payload->requests[r], &output_count));
+    for (uint32_t i = 0; i < output_count; i++) {
+      const char* output_name;
+      RETURN_IF_ERROR(TRITONBACKEND_RequestOutputName(
+          payload->requests[r], i, &output_name));
+      // The outputs of the requests mostly come in the order of the model.
+      size_t idx = i;
+      if ((idx >= output_names_.size()) ||
+          (strcmp(output_names_[idx], output_name) != 0)) {
+        for (idx = 0; idx < output_names_.size(); idx++) {
+          if (strcmp(output_names_[idx], output_name) == 0) {
+            break;
+          }
+        }
+      }
+      if ((idx < output_names_.size()) && !requested_outputs[idx]) {
+        requested_outputs[idx] = true;
+        requested_count++;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+void
+ModelInstanceState::CompleteExecution(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  TRITONBACKEND_Request** requests = payload->requests.data();
+  const uint32_t request_count = payload->requests.size();
+  std::vector<TRITONBACKEND_Response*>& responses = payload->responses;
+  bool& all_response_failed = payload->all_response_failed;
+
+  if (!all_response_failed) {
+    RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
+        responses, request_count, all_response_failed,
+        ReadOutputTensors(
+            slot, payload->batch_size, payload->total_batch_size,
+            payload->output_buffers, requests, request_count, &responses));
+  }
+  SET_TIMESTAMP(payload->outputs_scattered_ns);
+  ReadPerfCounters(slot, PerfStage::OUTPUTS, true /* end */);
+
+  if (!all_response_failed && (model_state_->ProfilingInterval() > 0)) {
+    SampleProfile(slot);
+  }
+  if (!all_response_failed && payload->perf_sampled) {
+    ObservePerfCounts(slot);
+  }
+  if (model_state_->CaptureTrace() != nullptr) {
+    LOG_IF_ERROR(CaptureExecution(slot), "failed to capture the execution");
+  }
+  if (!all_response_failed && model_state_->EnableLatencyParameters()) {
+    LOG_IF_ERROR(
+        SetLatencyParameters(slot),
+        "failed to set the latency parameters of the responses");
+  }
+
+  uint64_t exec_end_ns = 0;
+  SET_TIMESTAMP(exec_end_ns);
+
+  // Send all the responses that haven't already been sent because of
+  // an earlier error. Note that the responses are not set to nullptr
+  // here as we need that indication below to determine if the request
+  // we successful or not.
+  for (auto& response : responses) {
+    if (response != nullptr) {
+      LOG_IF_ERROR(
+          TRITONBACKEND_ResponseSend(
+              response, TRITONSERVER_RESPONSE_COMPLETE_FINAL, nullptr),
+          "failed to send openvino backend response");
+    }
+  }
+
+  // Report statistics for each request.
+  for (uint32_t r = 0; r < request_count; ++r) {
+    auto& request = requests[r];
+    LOG_IF_ERROR(
+        TRITONBACKEND_ModelInstanceReportStatistics(
+            TritonModelInstance(), request,
+            (responses[r] != nullptr) /* success */, payload->exec_start_ns,
+            payload->compute_start_ns, payload->compute_end_ns, exec_end_ns),
+        "failed reporting request statistics");
+
+    LOG_IF_ERROR(
+        TRITONBACKEND_RequestRelease(request, TRITONSERVER_REQUEST_RELEASE_ALL),
+        "failed releasing request");
+  }
+
+  if (!all_response_failed && (metrics_ != nullptr)) {
+    uint64_t release_end_ns = 0;
+    SET_TIMESTAMP(release_end_ns);
+    metrics_->ObserveStage(
+        ExecutionStage::GATHER_INPUTS, payload->prepare_start_ns,
+        payload->inputs_gathered_ns);
+    metrics_->ObserveStage(
+        ExecutionStage::COPY_INPUTS, payload->inputs_gathered_ns,
+        payload->inputs_copied_ns);
+    metrics_->ObserveStage(
+        ExecutionStage::INFER, payload->compute_start_ns,
+        payload->compute_end_ns);
+    metrics_->ObserveStage(
+        ExecutionStage::SCATTER_OUTPUTS, payload->compute_end_ns,
+        payload->outputs_scattered_ns);
+    metrics_->ObserveStage(
+        ExecutionStage::SEND_RESPONSES, payload->outputs_scattered_ns,
+        release_end_ns);
+  }
+
+  if (!all_response_failed) {
+    // Report the entire batch statistics.
+    LOG_IF_ERROR(
+        TRITONBACKEND_ModelInstanceReportBatchStatistics(
+            TritonModelInstance(), payload->total_batch_size,
+            payload->exec_start_ns, payload->compute_start_ns,
+            payload->compute_end_ns, exec_end_ns),
+        "failed reporting batch request statistics");
+  }
+
+  // Release the staging buffers of the inputs.
+  payload->collector.reset();
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::SetBatch(InferSlot* slot, const int batch_size)
+{
+  // Resize the request tensors of the inputs with a dynamic batch to the
+  // batch of this execution, the outputs are resized by the inference.
+  for (size_t idx = 0; idx < input_names_.size(); idx++) {
+    BoundTensor& input = slot->request->inputs[idx];
+    const ov::PartialShape& partial_shape = input.port.get_partial_shape();
+    if (partial_shape.rank().is_dynamic() || (partial_shape.size() == 0) ||
+        partial_shape[0].is_static()) {
+      continue;
+    }
+
+    if (input.shape[0] != (size_t)batch_size) {
+      ov::Shape& shape = slot->payload.tensor_shape;
+      shape.assign(input.shape.begin(), input.shape.end());
+      shape[0] = batch_size;
+      RETURN_IF_OPENVINO_ERROR(
+          input.owned.set_shape(shape),
+          "setting batch size for input " + input_names_[idx]);
+      input.shape.assign(shape.begin(), shape.end());
+    }
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::Infer(
+    InferSlot* slot, std::vector<TRITONBACKEND_Response*>* responses,
+    const uint32_t response_count)
+{
+  if (slot->payload.micro_batch_count > 0) {
+    return InferMicroBatches(slot);
+  }
+
+  RETURN_IF_OPENVINO_ERROR(
+      slot->request->infer_request.infer(), "running inference");
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::InferAsync(InferSlot* slot)
+{
+  if (slot->payload.micro_batch_count > 0) {
+    StartMicroBatches(slot);
+    return nullptr;
+  }
+
+  RETURN_IF_OPENVINO_ERROR(
+      slot->request->infer_request.start_async(),
+      "starting asynchronous inference");
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::StartInfer(InferSlot* slot)
+{
+  RETURN_IF_OPENVINO_ERROR(
+      slot->request->infer_request.start_async(), "starting inference");
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::WaitInfer(InferSlot* slot)
+{
+  RETURN_IF_OPENVINO_ERROR(
+      slot->request->infer_request.wait(), "running inference");
+
+  return nullptr;
+}
+
+void
+ModelInstanceState::InferComplete(
+    InferSlot* slot, std::exception_ptr exception)
+{
+  Payload* payload = &slot->payload;
+  SET_TIMESTAMP(payload->compute_end_ns);
+
+  if (exception != nullptr) {
+    std::string error_str;
+    try {
+      std::rethrow_exception(exception);
+    }
+    catch (const std::exception& error) {
+      error_str = error.what();
+    }
+    catch (...) {
+      error_str = "unknown/internal exception happened";
+    }
     RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
-        responses, request_count, all_response_failed,
-        SetInputTensors(
-            total_batch_size, requests, request_count, &responses,
-            &input_names));
+        payload->responses, payload->requests.size(),
+        payload->all_response_failed,
+        TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INTERNAL,
+            (std::string("openvino error in running inference : ") +
+             error_str)
+                .c_str()));
   }
 
-  // Request to retrieve all model outputs.
-  std::vector<const char*> output_names;
-  if (!all_response_failed) {
-    triton::common::TritonJson::Value ios;
-    TRITONSERVER_Error* err =
-        model_state_->ModelConfig().MemberAsArray("output", &ios);
-    if (err == nullptr) {
-      for (size_t i = 0; i < ios.ArraySize(); i++) {
-        triton::common::TritonJson::Value io;
-        err = ios.IndexAsObject(i, &io);
-        if (err != nullptr) {
-          break;
-        }
+  CompleteExecution(slot);
+  ReleaseSlot(slot);
+}
 
-        // Use names from ModelConfig by reference since the model
-        // config will persist longer than this inference execution.
-        const char* io_name;
-        size_t io_name_len;
-        err = io.MemberAsString("name", &io_name, &io_name_len);
-        if (err != nullptr) {
-          break;
-        }
+TRITONSERVER_Error*
+ModelInstanceState::SetMicroBatches(InferSlot* slot)
+{
+  Payload* payload = &slot->payload;
+  BoundRequest* request = slot->request;
+  const size_t total_batch_size = payload->total_batch_size;
+  if (total_batch_size <= micro_batch_size_) {
+    return nullptr;
+  }
 
-        output_names.emplace_back(io_name);
+  // The tensors holding the whole batch, split by rows. The outputs must
+  // be allocated for the whole batch before the inference, so their
+  // shape must be known other than the batch.
+  std::vector<ov::Tensor>& inputs = payload->micro_batch_inputs;
+  inputs.resize(input_names_.size());
+  for (size_t idx = 0; idx < inputs.size(); idx++) {
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        inputs[idx],
+        request->infer_request.get_tensor(request->inputs[idx].port),
+        "getting request tensor for input " + input_names_[idx]);
+    if (inputs[idx].get_shape().empty() ||
+        (inputs[idx].get_shape()[0] != total_batch_size)) {
+      return nullptr;
+    }
+  }
+  std::vector<ov::Shape>& output_shapes = payload->micro_batch_output_shapes;
+  output_shapes.resize(output_names_.size());
+  for (size_t idx = 0; idx < output_shapes.size(); idx++) {
+    const ov::PartialShape& partial_shape =
+        request->outputs[idx].port.get_partial_shape();
+    if (partial_shape.rank().is_dynamic() || (partial_shape.size() == 0)) {
+      return nullptr;
+    }
+    output_shapes[idx].assign(1, total_batch_size);
+    for (size_t i = 1; i < partial_shape.size(); i++) {
+      if (partial_shape[i].is_dynamic()) {
+        return nullptr;
       }
+      output_shapes[idx].push_back(partial_shape[i].get_length());
     }
   }
 
-  uint64_t compute_start_ns = 0;
-  SET_TIMESTAMP(compute_start_ns);
-
-  // Run...
-  if (!all_response_failed) {
-	  RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
-			  responses, request_count, all_response_failed,
-			  Infer(&responses, request_count));
+  std::vector<ov::Tensor>& outputs = payload->micro_batch_outputs;
+  outputs.resize(output_names_.size());
+  for (size_t idx = 0; idx < outputs.size(); idx++) {
+    const ov::Output<const ov::Node>& port = request->outputs[idx].port;
+    RETURN_IF_OPENVINO_ASSIGN_ERROR(
+        outputs[idx], request->infer_request.get_tensor(port),
+        std::string("getting request tensor for output ") +
+            output_names_[idx]);
+    if (outputs[idx].get_shape() != output_shapes[idx]) {
+      RETURN_IF_OPENVINO_ERROR(
+          outputs[idx].set_shape(output_shapes[idx]),
+          std::string("setting shape for output ") + output_names_[idx]);
+      RETURN_IF_OPENVINO_ERROR(
+          request->infer_request.set_tensor(port, outputs[idx]),
+          std::string("setting request tensor for output ") +
+              output_names_[idx]);
+    }
   }
 
-  uint64_t compute_end_ns = 0;
-  SET_TIMESTAMP(compute_end_ns);
-
-  if (!all_response_failed) {
-    RESPOND_ALL_AND_SET_TRUE_IF_ERROR(
-        responses, request_count, all_response_failed,
-        ReadOutputTensors(
-            total_batch_size, output_names, requests, request_count,
-            &responses));
+  // Spread the rows evenly over the micro-batches, of which there may be
+  // fewer than requested once the rows are rounded up.
+  size_t count = std::min(
+      (total_batch_size + micro_batch_size_ - 1) / micro_batch_size_,
+      slot->micro_requests.size());
+  const size_t rows = (total_batch_size + count - 1) / count;
+  count = (total_batch_size + rows - 1) / rows;
+  for (size_t m = 0; m < count; m++) {
+    BoundRequest* micro_request = slot->micro_requests[m].get();
+    const size_t begin = m * rows;
+    const size_t micro_rows = std::min(rows, total_batch_size - begin);
+    for (size_t idx = 0; idx < inputs.size(); idx++) {
+      ov::Shape shape = inputs[idx].get_shape();
+      const size_t row_byte_size = inputs[idx].get_byte_size() / shape[0];
+      shape[0] = micro_rows;
+      RETURN_IF_OPENVINO_ERROR(
+          micro_request->infer_request.set_tensor(
+              micro_request->inputs[idx].port,
+              ov::Tensor(
+                  inputs[idx].get_element_type(), shape,
+                  reinterpret_cast<char*>(inputs[idx].data()) +
+                      begin * row_byte_size)),
+          "binding micro-batch of input " + input_names_[idx]);
+    }
+    for (size_t idx = 0; idx < outputs.size(); idx++) {
+      ov::Shape shape = outputs[idx].get_shape();
+      const size_t row_byte_size = outputs[idx].get_byte_size() / shape[0];
+      shape[0] = micro_rows;
+      RETURN_IF_OPENVINO_ERROR(
+          micro_request->infer_request.set_tensor(
+              micro_request->outputs[idx].port,
+              ov::Tensor(
+                  outputs[idx].get_element_type(), shape,
+                  reinterpret_cast<char*>(outputs[idx].data()) +
+                      begin * row_byte_size)),
+          std::string("binding micro-batch of output ") + output_names_[idx]);
+    }
   }
 
-  uint64_t exec_end_ns = 0;
-  SET_TIMESTAMP(exec_end_ns);
+  payload->micro_batch_count = count;
+  micro_batch_exec_count_++;
 
-  // Send all the responses that haven't already been sent because of
-  // an earlier error. Note that the responses are not set to nullptr
-  // here as we need that indication below to determine if the request
-  // we successful or not.
-  for (auto& response : responses) {
-    if (response != nullptr) {
-      LOG_IF_ERROR(
-          TRITONBACKEND_ResponseSend(
-              response, TRITONSERVER_RESPONSE_COMPLETE_FINAL, nullptr),
-          "failed to send openvino backend response");
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::InferMicroBatches(InferSlot* slot)
+{
+  const size_t count = slot->payload.micro_batch_count;
+
+  // Wait for every micro-batch started, even after a failure, as they
+  // write into the tensors of the execution.
+  std::string error_str;
+  size_t started = 0;
+  for (; started < count; started++) {
+    try {
+      slot->micro_requests[started]->infer_request.start_async();
+    }
+    catch (const std::exception& error) {
+      error_str = error.what();
+      break;
     }
   }
-
-  // Report statistics for each request.
-  for (uint32_t r = 0; r < request_count; ++r) {
-    auto& request = requests[r];
-    LOG_IF_ERROR(
-        TRITONBACKEND_ModelInstanceReportStatistics(
-            TritonModelInstance(), request,
-            (responses[r] != nullptr) /* success */, exec_start_ns,
-            compute_start_ns, compute_end_ns, exec_end_ns),
-        "failed reporting request statistics");
-
-    LOG_IF_ERROR(
-        TRITONBACKEND_RequestRelease(request, TRITONSERVER_REQUEST_RELEASE_ALL),
-        "failed releasing request");
+  for (size_t m = 0; m < started; m++) {
+    try {
+      slot->micro_requests[m]->infer_request.wait();
+    }
+    catch (const std::exception& error) {
+      if (error_str.empty()) {
+        error_str = error.what();
+      }
+    }
   }
 
-  //printf("conpute input time: %ld, infer time: %ld, compute output time: %ld\n", (compute_start_ns-exec_start_ns), (compute_end_ns-compute_start_ns), (exec_end_ns-compute_end_ns));
-
-  if (!all_response_failed) {
-    // Report the entire batch statistics.
-    LOG_IF_ERROR(
-        TRITONBACKEND_ModelInstanceReportBatchStatistics(
-            TritonModelInstance(), total_batch_size, exec_start_ns,
-            compute_start_ns, compute_end_ns, exec_end_ns),
-        "failed reporting batch request statistics");
+  if (!error_str.empty()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("openvino error in running micro-batches : ") +
+         error_str)
+            .c_str());
   }
+
+  return nullptr;
 }
 
-TRITONSERVER_Error*
-ModelInstanceState::SetBatch(const int batch_size)
+void
+ModelInstanceState::StartMicroBatches(InferSlot* slot)
 {
-  //RETURN_IF_OPENVINO_ERROR(
-  //    infer_request_.SetBatch(batch_size), "setting batch size");
+  Payload* payload = &slot->payload;
+  const size_t count = payload->micro_batch_count;
 
-  return nullptr;
+  // The starting thread holds one more count than there are micro-batches
+  // so that the execution doesn't complete before all are started.
+  {
+    std::lock_guard<std::mutex> lock(payload->micro_batch_mu);
+    payload->pending_micro_batches = count + 1;
+    payload->micro_batch_exception = nullptr;
+  }
+
+  size_t started = 0;
+  std::exception_ptr exception;
+  for (; started < count; started++) {
+    try {
+      slot->micro_requests[started]->infer_request.start_async();
+    }
+    catch (...) {
+      exception = std::current_exception();
+      break;
+    }
+  }
+
+  MicroBatchComplete(slot, 1 + (count - started), exception);
 }
 
-TRITONSERVER_Error*
-ModelInstanceState::Infer(
-    std::vector<TRITONBACKEND_Response*>* responses,
-    const uint32_t response_count)
+void
+ModelInstanceState::MicroBatchComplete(
+    InferSlot* slot, const size_t done, std::exception_ptr exception)
 {
-  RETURN_IF_OPENVINO_ERROR(infer_request_.infer(), "running inference");
+  Payload* payload = &slot->payload;
+  std::exception_ptr first_exception;
+  {
+    std::lock_guard<std::mutex> lock(payload->micro_batch_mu);
+    if ((exception != nullptr) && (payload->micro_batch_exception == nullptr)) {
+      payload->micro_batch_exception = exception;
+    }
+    payload->pending_micro_batches -= done;
+    if (payload->pending_micro_batches > 0) {
+      return;
+    }
+    first_exception = payload->micro_batch_exception;
+  }
 
-  return nullptr;
+  InferComplete(slot, first_exception);
 }
 
 TRITONSERVER_Error*
 ModelInstanceState::SetInputTensors(
-    size_t total_batch_size, TRITONBACKEND_Request** requests,
-    const uint32_t request_count,
-    std::vector<TRITONBACKEND_Response*>* responses,
-    std::vector<const char*>* input_names)
+    InferSlot* slot, size_t batch_size, size_t total_batch_size,
+    TRITONBACKEND_Request** requests, const uint32_t request_count,
+    std::vector<TRITONBACKEND_Response*>* responses)
 {
   const int max_batch_size = model_state_->MaxBatchSize();
 
@@ -1131,15 +4113,14 @@ ModelInstanceState::SetInputTensors(
   uint32_t input_count;
   RETURN_IF_ERROR(TRITONBACKEND_RequestInputCount(requests[0], &input_count));
 
-  //InferenceEngine::InputsDataMap input_tensor_infos;
-  std::map<std::string, ov::TensorVector> inputsData;
-  //del by zhaohb 
-  //RETURN_IF_ERROR(model_state_->GetInputsInfo(&input_tensor_infos));
+  // The inputs are only read from CPU memory.
+  static const std::vector<std::pair<TRITONSERVER_MemoryType, int64_t>>
+      allowed_input_types = {
+          {TRITONSERVER_MEMORY_CPU_PINNED, 0}, {TRITONSERVER_MEMORY_CPU, 0}};
 
-  BackendInputCollector collector(
-      requests, request_count, responses, model_state_->TritonMemoryManager(),
-      model_state_->EnablePinnedInput(), CudaStream(), nullptr, nullptr, 0,
-      HostPolicyName().c_str());
+  Payload* payload = &slot->payload;
+  std::vector<PendingCopy>& pending_copies = payload->pending_copies;
+  pending_copies.clear();
 
   for (uint32_t input_idx = 0; input_idx < input_count; input_idx++) {
     TRITONBACKEND_Input* input;
@@ -1154,121 +4135,597 @@ ModelInstanceState::SetInputTensors(
         input, &input_name, &input_datatype, &input_shape, &input_dims_count,
         nullptr, nullptr));
 
-    input_names->emplace_back(input_name);
+    const size_t idx = InputIndex(input_name, input_idx);
+    if (idx == input_names_.size()) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("unexpected input '") + input_name + "' for model '" +
+           model_state_->Name() + "'")
+              .c_str());
+    }
 
     // The shape for the entire input patch, [total_batch_size, ...]
-    std::vector<int64_t> batchn_shape(
-        input_shape, input_shape + input_dims_count);
+    std::vector<int64_t>& batchn_shape = payload->shape;
+    batchn_shape.assign(input_shape, input_shape + input_dims_count);
     if (max_batch_size != 0) {
       batchn_shape[0] = total_batch_size;
     }
 
     const int64_t batchn_byte_size = GetByteSize(input_datatype, batchn_shape);
+    const ov::element::Type element_type =
+        ConvertToOpenVINOElement(input_datatype);
+    ov::Shape& shape = payload->tensor_shape;
+    shape.assign(batchn_shape.begin(), batchn_shape.end());
+    // The shape of the request tensor, whose rows past the total batch
+    // size are padding when the batch is padded up to a batch bucket.
+    ov::Shape& request_shape = payload->request_shape;
+    request_shape.assign(shape.begin(), shape.end());
+    if (max_batch_size != 0) {
+      request_shape[0] = batch_size;
+    }
+
+    // In copy mode the inputs of the requests are gathered straight into
+    // the request tensor.
+    ov::Tensor* request_tensor = nullptr;
+    if (!model_state_->EnableZeroCopyInput()) {
+      RETURN_IF_ERROR(GetRequestTensor(
+          slot, idx, element_type, request_shape, &request_tensor));
+      ZeroPaddingRows(slot, idx, total_batch_size);
+      RETURN_IF_ERROR(GatherInput(
+          slot, input_name, total_batch_size,
+          reinterpret_cast<char*>(request_tensor->data()), batchn_byte_size));
+      copy_input_count_++;
+      continue;
+    }
+
+    // In zero-copy mode no destination is given to the collector, so it
+    // passes the request buffer through if the whole batch is contiguous
+    // in a single request and only gathers into its own staging buffer
+    // otherwise.
+    if (payload->collector == nullptr) {
+      payload->collector.reset(new BackendInputCollector(
+          requests, request_count, responses,
+          model_state_->TritonMemoryManager(),
+          model_state_->EnablePinnedInput(), CudaStream(), nullptr, nullptr, 0,
+          HostPolicyName().c_str()));
+    }
+    const char* input_buffer;
+    size_t buffer_byte_size;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    RETURN_IF_ERROR(payload->collector->ProcessTensor(
+        input_name, nullptr, 0, allowed_input_types, &input_buffer,
+        &buffer_byte_size, &memory_type, &memory_type_id));
+    if (memory_type == TRITONSERVER_MEMORY_GPU) {
+      RETURN_IF_ERROR(TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          "failed to get input buffer in CPU memory"));
+    }
+
+    if ((uint64_t)batchn_byte_size != buffer_byte_size) {
+      RETURN_IF_ERROR(TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          std::string(
+              "expected " + std::to_string(batchn_byte_size) +
+              " bytes of data in input buffer, got " +
+              std::to_string(buffer_byte_size) + " bytes.")
+              .c_str()));
+    }
+
+    bool bound = false;
+    RETURN_IF_ERROR(BindInputBuffer(
+        slot, idx, element_type, shape, input_buffer, memory_type, &bound));
+    if (bound) {
+      zero_copy_input_count_++;
+    } else {
+      RETURN_IF_ERROR(GetRequestTensor(
+          slot, idx, element_type, request_shape, &request_tensor));
+      ZeroPaddingRows(slot, idx, total_batch_size);
+      pending_copies.push_back(
+          {reinterpret_cast<char*>(request_tensor->data()), input_buffer,
+           buffer_byte_size});
+      copy_input_count_++;
+    }
+  }
+
+  // Wait for any pending copies into the gathered buffers.
+  if (payload->collector != nullptr) {
+    payload->collector->Finalize();
+  }
+  SET_TIMESTAMP(payload->inputs_gathered_ns);
+
+  for (auto& copy : pending_copies) {
+    memcpy(copy.data, copy.buffer, copy.byte_size);
+  }
+  SET_TIMESTAMP(payload->inputs_copied_ns);
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::GatherInput(
+    InferSlot* slot, const char* name, const size_t total_batch_size,
+    char* buffer, const size_t byte_size)
+{
+  Payload* payload = &slot->payload;
+  const char* host_policy = HostPolicyName().c_str();
+  const bool batching = (model_state_->MaxBatchSize() > 0);
+  const size_t row_byte_size =
+      (batching && (total_batch_size > 0)) ? byte_size / total_batch_size
+                                           : byte_size;
+  size_t offset = 0;
+  for (size_t r = 0; r < payload->requests.size(); r++) {
+    TRITONBACKEND_Request* request = payload->requests[r];
+    TRITONBACKEND_Response** response = &payload->responses[r];
+
+    // The rows of each request follow those of the previous requests,
+    // whether its input is copied or not, as ScatterOutput() reads them.
+    size_t rows = 1;
+    if (batching) {
+      TRITONBACKEND_Input* input;
+      const int64_t* shape;
+      RETURN_IF_ERROR(
+          TRITONBACKEND_RequestInputByIndex(request, 0 /* index */, &input));
+      RETURN_IF_ERROR(TRITONBACKEND_InputProperties(
+          input, nullptr, nullptr, &shape, nullptr, nullptr, nullptr));
+      rows = shape[0];
+    }
+    const size_t request_byte_size = rows * row_byte_size;
+    if (request_byte_size > byte_size - offset) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("expected ") + std::to_string(byte_size) +
+           " bytes of data in input '" + name + "', the requests take more")
+              .c_str());
+    }
+
+    TRITONBACKEND_Input* input;
+    uint64_t input_byte_size = 0;
+    uint32_t buffer_count = 0;
+    TRITONSERVER_Error* err =
+        TRITONBACKEND_RequestInput(request, name, &input);
+    if (err == nullptr) {
+      err = TRITONBACKEND_InputPropertiesForHostPolicy(
+          input, host_policy, nullptr, nullptr, nullptr, nullptr,
+          &input_byte_size, &buffer_count);
+    }
+    if ((err == nullptr) && (input_byte_size != request_byte_size)) {
+      err = TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("expected ") + std::to_string(request_byte_size) +
+           " bytes of data in input '" + name + "', got " +
+           std::to_string(input_byte_size))
+              .c_str());
+    }
+    RESPOND_AND_SET_NULL_IF_ERROR(response, err);
 
-      const char* input_buffer;
-      //const char* input_buffer;
-      size_t buffer_byte_size;
+    size_t buffer_offset = offset;
+    for (uint32_t b = 0; (*response != nullptr) && (b < buffer_count); b++) {
+      const void* src;
+      uint64_t src_byte_size;
       TRITONSERVER_MemoryType memory_type;
       int64_t memory_type_id;
-      RETURN_IF_ERROR(collector.ProcessTensor(
-          input_name, nullptr, 0,
-          {{TRITONSERVER_MEMORY_CPU_PINNED, 0}, {TRITONSERVER_MEMORY_CPU, 0}},
-          &input_buffer, &buffer_byte_size, &memory_type, &memory_type_id));
-      if (memory_type == TRITONSERVER_MEMORY_GPU) {
-        RETURN_IF_ERROR(TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_UNSUPPORTED,
-            "failed to get input buffer in CPU memory"));
+      RESPOND_AND_SET_NULL_IF_ERROR(
+          response, TRITONBACKEND_InputBufferForHostPolicy(
+                        input, host_policy, b, &src, &src_byte_size,
+                        &memory_type, &memory_type_id));
+      if ((*response != nullptr) &&
+          (((memory_type != TRITONSERVER_MEMORY_CPU) &&
+            (memory_type != TRITONSERVER_MEMORY_CPU_PINNED)) ||
+           (src_byte_size > offset + request_byte_size - buffer_offset))) {
+        RESPOND_AND_SET_NULL_IF_ERROR(
+            response,
+            TRITONSERVER_ErrorNew(
+                TRITONSERVER_ERROR_UNSUPPORTED,
+                (std::string("failed to get input buffer in CPU memory for '") +
+                 name + "'")
+                    .c_str()));
       }
+      if (*response != nullptr) {
+        memcpy(buffer + buffer_offset, src, src_byte_size);
+        buffer_offset += src_byte_size;
+      }
+    }
+    offset += request_byte_size;
+  }
 
-      if ((uint64_t)batchn_byte_size != buffer_byte_size) {
-        RETURN_IF_ERROR(TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_UNSUPPORTED,
-            std::string(
-                "expected " + std::to_string(batchn_byte_size) +
-                " bytes of data in input buffer, got " +
-                std::to_string(buffer_byte_size) + " bytes.")
-                .c_str()));
+  // Fewer rows than the batch would leave those of the previous batch in
+  // the tensor.
+  if (offset != byte_size) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("expected ") + std::to_string(byte_size) +
+         " bytes of data in input '" + name + "', got " +
+         std::to_string(offset))
+            .c_str());
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::ScatterOutput(
+    InferSlot* slot, const char* name, const TRITONSERVER_DataType datatype,
+    std::vector<int64_t>* batchn_shape, const char* buffer,
+    const size_t byte_size)
+{
+  Payload* payload = &slot->payload;
+  const bool batching = (model_state_->MaxBatchSize() > 0);
+  size_t offset = 0;
+  for (size_t r = 0; r < payload->requests.size(); r++) {
+    TRITONBACKEND_Request* request = payload->requests[r];
+    TRITONBACKEND_Response** response = &payload->responses[r];
+
+    // The rows of each request follow those of the previous requests,
+    // whether they are sent or not.
+    if (batching) {
+      TRITONBACKEND_Input* input;
+      const int64_t* shape;
+      RETURN_IF_ERROR(
+          TRITONBACKEND_RequestInputByIndex(request, 0 /* index */, &input));
+      RETURN_IF_ERROR(TRITONBACKEND_InputProperties(
+          input, nullptr, nullptr, &shape, nullptr, nullptr, nullptr));
+      (*batchn_shape)[0] = shape[0];
+    }
+    const size_t tensor_byte_size = GetByteSize(datatype, *batchn_shape);
+    if (tensor_byte_size > byte_size - offset) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          (std::string("expected ") + std::to_string(byte_size) +
+           " bytes of data in output '" + name + "', the requests take more")
+              .c_str());
+    }
+
+    bool requested = false;
+    uint32_t output_count = 0;
+    if (*response != nullptr) {
+      RESPOND_AND_SET_NULL_IF_ERROR(
+          response, TRITONBACKEND_RequestOutputCount(request, &output_count));
+    }
+    for (uint32_t i = 0;
+         (*response != nullptr) && !requested && (i < output_count); i++) {
+      const char* output_name;
+      RESPOND_AND_SET_NULL_IF_ERROR(
+          response, TRITONBACKEND_RequestOutputName(request, i, &output_name));
+      requested = (*response != nullptr) && (strcmp(output_name, name) == 0);
+    }
+
+    if (requested) {
+      TRITONBACKEND_Output* output;
+      void* output_buffer = nullptr;
+      TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+      int64_t memory_type_id = 0;
+      RESPOND_AND_SET_NULL_IF_ERROR(
+          response, TRITONBACKEND_ResponseOutput(
+                        *response, &output, name, datatype,
+                        batchn_shape->data(), batchn_shape->size()));
+      if (*response != nullptr) {
+        RESPOND_AND_SET_NULL_IF_ERROR(
+            response, TRITONBACKEND_OutputBuffer(
+                          output, &output_buffer, tensor_byte_size,
+                          &memory_type, &memory_type_id));
       }
+      if ((*response != nullptr) &&
+          (memory_type != TRITONSERVER_MEMORY_CPU) &&
+          (memory_type != TRITONSERVER_MEMORY_CPU_PINNED)) {
+        RESPOND_AND_SET_NULL_IF_ERROR(
+            response,
+            TRITONSERVER_ErrorNew(
+                TRITONSERVER_ERROR_UNSUPPORTED,
+                (std::string(
+                     "failed to get output buffer in CPU memory for '") +
+                 name + "'")
+                    .c_str()));
+      }
+      if (*response != nullptr) {
+        memcpy(output_buffer, buffer + offset, tensor_byte_size);
+      }
+    }
+    offset += tensor_byte_size;
+  }
 
-      // Set the input blob to the buffer without allocating any new memory
+  return nullptr;
+}
 
-      ov::Tensor input_tensor;
+TRITONSERVER_Error*
+ModelInstanceState::GetRequestTensor(
+    InferSlot* slot, const size_t input_idx,
+    const ov::element::Type& element_type, const ov::Shape& shape,
+    ov::Tensor** tensor)
+{
+  // Restore the request-owned tensor if a previous execution bound an
+  // external buffer to this input.
+  BoundTensor& input = slot->request->inputs[input_idx];
+  const ov::Output<const ov::Node>& port = input.port;
+  const std::string& input_name = input_names_[input_idx];
+  if (input.bound) {
+    RETURN_IF_OPENVINO_ERROR(
+        slot->request->infer_request.set_tensor(port, input.owned),
+        "restoring request tensor for input " + input_name);
+    input.bound = false;
+  }
 
-      const void* input_buffer_ptr = (const void *)(input_buffer); 
-      auto input_data =  reinterpret_cast<float*>(const_cast<void*>(input_buffer_ptr));   
+  // The owned tensor is the one the infer request reads, and its shape is
+  // tracked along with it, so neither is asked from OpenVINO, which
+  // returns copies of them.
+  *tensor = &input.owned;
 
+  // Inputs with dynamic dimensions take the shape of each execution. The
+  // tensor may be reallocated so none of its rows is known to be zero.
+  if ((input.shape != shape) && port.get_partial_shape().is_dynamic() &&
+      IsCompatibleShape(port.get_partial_shape(), shape)) {
+    RETURN_IF_OPENVINO_ERROR(
+        input.owned.set_shape(shape), "setting shape for input " + input_name);
+    input.shape.assign(shape.begin(), shape.end());
+    input.zero_rows_from = SIZE_MAX;
+  }
 
-      //uint64_t ov_init_start_ns = 0;
-      //SET_TIMESTAMP(ov_init_start_ns);
-      input_tensor = ov::Tensor(ConvertToOpenVINOElement(input_datatype), 
-                                std::vector<size_t>(batchn_shape.begin(), batchn_shape.end()),    
-		                input_data);     
+  if ((input.shape != shape) ||
+      (input.owned.get_element_type() != element_type)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("unexpected shape or datatype for input '") +
+         input_name + "' of model '" + model_state_->Name() +
+         "', model expects " +
+         ShapeToString(ConvertToSignedShape(input.shape)) + " of " +
+         input.owned.get_element_type().get_type_name() + ", got " +
+         ShapeToString(ConvertToSignedShape(shape)) + " of " +
+         element_type.get_type_name())
+            .c_str());
+  }
 
-      auto requestTensor = infer_request_.get_tensor(name_node_map_[input_name]);
-      //requestTensor.set_shape(input_shape_tmp);
+  return nullptr;
+}
 
-#if 0
-      printf("input_name: %s, input get_byte_size: %zu, output get_byte_size: %zu\n", input_name, input_tensor.get_byte_size(), requestTensor.get_byte_size());
-#endif
-      if (input_tensor.get_shape() != requestTensor.get_shape() || input_tensor.get_byte_size() != requestTensor.get_byte_size()) {
-	      throw std::runtime_error(
-			      "Source and destination tensors shapes and byte sizes are expected to be equal for data copying.");
+void
+ModelInstanceState::ZeroPaddingRows(
+    InferSlot* slot, const size_t input_idx, const size_t total_batch_size)
+{
+  BoundTensor& input = slot->request->inputs[input_idx];
+  const ov::Shape& shape = input.shape;
+  if ((model_state_->MaxBatchSize() == 0) || shape.empty() ||
+      (shape[0] == 0)) {
+    return;
+  }
+
+  // The rows below 'total_batch_size' are about to be written by the
+  // batch, so only the rows between it and the zeroed rows need zeroing.
+  const size_t batch_size = shape[0];
+  const size_t zero_rows_from = std::min(input.zero_rows_from, batch_size);
+  if (total_batch_size < zero_rows_from) {
+    const size_t row_byte_size = input.owned.get_byte_size() / batch_size;
+    memset(
+        reinterpret_cast<char*>(input.owned.data()) +
+            total_batch_size * row_byte_size,
+        0, (zero_rows_from - total_batch_size) * row_byte_size);
+  }
+  input.zero_rows_from = std::min(total_batch_size, batch_size);
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::BindInputBuffer(
+    InferSlot* slot, const size_t input_idx,
+    const ov::element::Type& element_type, const ov::Shape& shape,
+    const char* buffer, TRITONSERVER_MemoryType memory_type, bool* bound)
+{
+  *bound = false;
+  BoundTensor& input = slot->request->inputs[input_idx];
+  const ov::Output<const ov::Node>& port = input.port;
+
+  // The buffer stays valid until the requests are released and the
+  // collector is destroyed, both of which happen only after inference
+  // completes. It must however live in CPU memory, be contiguous in the
+  // exact shape and element type the model was compiled for, and be
+  // aligned for that element type.
+  if ((memory_type != TRITONSERVER_MEMORY_CPU) &&
+      (memory_type != TRITONSERVER_MEMORY_CPU_PINNED)) {
+    return nullptr;
+  }
+  if ((port.get_element_type() != element_type) ||
+      !IsCompatibleShape(port.get_partial_shape(), shape)) {
+    return nullptr;
+  }
+  if ((reinterpret_cast<uintptr_t>(buffer) % element_type.size()) != 0) {
+    return nullptr;
+  }
+
+  ov::Tensor tensor(
+      element_type, shape, const_cast<void*>(static_cast<const void*>(buffer)));
+  RETURN_IF_OPENVINO_ERROR(
+      slot->request->infer_request.set_tensor(port, tensor),
+      "binding buffer for input " + input_names_[input_idx]);
+  input.bound = true;
+  *bound = true;
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ModelInstanceState::BindOutputBuffers(
+    InferSlot* slot, size_t total_batch_size,
+    TRITONBACKEND_Request** requests, const uint32_t request_count,
+    std::vector<TRITONBACKEND_Response*>* responses,
+    std::vector<char*>* output_buffers)
+{
+  // Only a single response can own the whole output of the batch, with
+  // more requests the outputs are scattered by the output responder.
+  const bool bind = (request_count == 1) && ((*responses)[0] != nullptr);
+  BoundRequest* request = slot->request;
+
+  for (size_t idx = 0; idx < output_names_.size(); idx++) {
+    const char* name = output_names_[idx];
+    BoundTensor& bound_output = request->outputs[idx];
+    const ov::Output<const ov::Node>& port = bound_output.port;
+    if (port.get_node() == nullptr) {
+      continue;
+    }
+
+    const bool requested = bind && slot->payload.requested_outputs[idx];
+
+    // The output shape must be known before the inference, and for the
+    // batching models it must hold exactly the rows of the request. The
+    // batch dimension is either fixed or follows the batch of the
+    // execution when the network has a dynamic batch.
+    const TRITONSERVER_DataType datatype =
+        ConvertFromOpenVINOElement(port.get_element_type());
+    const ov::PartialShape& partial_shape = port.get_partial_shape();
+    const bool batching = (model_state_->MaxBatchSize() > 0);
+    bool bindable = requested && partial_shape.rank().is_static() &&
+                    (datatype != TRITONSERVER_TYPE_INVALID);
+    std::vector<int64_t>& shape = slot->payload.shape;
+    shape.clear();
+    for (size_t i = 0; bindable && (i < partial_shape.size()); i++) {
+      const ov::Dimension& dim = partial_shape[i];
+      if (batching && (i == 0)) {
+        bindable = dim.is_dynamic() ||
+                   ((size_t)dim.get_length() == total_batch_size);
+        shape.push_back(total_batch_size);
+      } else {
+        bindable = dim.is_static();
+        shape.push_back(bindable ? dim.get_length() : 0);
+      }
+    }
+    bindable &= (!batching || !shape.empty());
+
+    if (bindable) {
+      TRITONBACKEND_Output* output;
+      RETURN_IF_ERROR(TRITONBACKEND_ResponseOutput(
+          (*responses)[0], &output, name, datatype, shape.data(),
+          shape.size()));
+      const uint64_t byte_size = GetByteSize(datatype, shape);
+      void* buffer;
+      TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+      int64_t memory_type_id = 0;
+      RETURN_IF_ERROR(TRITONBACKEND_OutputBuffer(
+          output, &buffer, byte_size, &memory_type, &memory_type_id));
+      if ((memory_type != TRITONSERVER_MEMORY_CPU) &&
+          (memory_type != TRITONSERVER_MEMORY_CPU_PINNED)) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_UNSUPPORTED,
+            (std::string("failed to get output buffer in CPU memory for '") +
+             name + "'")
+                .c_str());
+      }
+      (*output_buffers)[idx] = reinterpret_cast<char*>(buffer);
+
+      // A misaligned buffer is still filled, from the request tensor
+      // once the inference completes.
+      if ((reinterpret_cast<uintptr_t>(buffer) %
+           port.get_element_type().size()) == 0) {
+        ov::Shape& tensor_shape = slot->payload.tensor_shape;
+        tensor_shape.assign(shape.begin(), shape.end());
+        RETURN_IF_OPENVINO_ERROR(
+            request->infer_request.set_tensor(
+                port,
+                ov::Tensor(port.get_element_type(), tensor_shape, buffer)),
+            std::string("binding buffer for output ") + name);
+        bound_output.bound = true;
+        zero_copy_output_count_++;
+        continue;
       }
+    }
 
-      memcpy(requestTensor.data(), input_tensor.data(), input_tensor.get_byte_size());
-      //infer_request_.set_tensor(name_node_map_[input_name], input_tensor);
+    // The buffer bound by a previous execution has been released along
+    // with its response, so let the inference write into the tensor
+    // owned by the request again.
+    if (bound_output.bound) {
+      RETURN_IF_OPENVINO_ERROR(
+          request->infer_request.set_tensor(port, bound_output.owned),
+          std::string("restoring request tensor for output ") + name);
+      bound_output.bound = false;
     }
+  }
+
   return nullptr;
 }
 
 TRITONSERVER_Error*
 ModelInstanceState::ReadOutputTensors(
-    size_t total_batch_size, const std::vector<const char*>& output_names,
+    InferSlot* slot, size_t batch_size, size_t total_batch_size,
+    const std::vector<char*>& output_buffers,
     TRITONBACKEND_Request** requests, const uint32_t request_count,
     std::vector<TRITONBACKEND_Response*>* responses)
 {
-  BackendOutputResponder responder(
-      requests, request_count, responses, model_state_->TritonMemoryManager(),
-      model_state_->MaxBatchSize() > 0, model_state_->EnablePinnedInput(),
-      CudaStream());
-
-  bool cuda_copy = false;
-  for (size_t idx = 0; idx < output_names.size(); idx++) {
-    std::string name = output_names[idx];
+  for (size_t idx = 0; idx < output_names_.size(); idx++) {
+    const char* name = output_names_[idx];
+    const BoundTensor& bound_output = slot->request->outputs[idx];
+
+    // Outputs no request asked for are left in the infer request, and
+    // outputs bound to the response buffer have already been written by
+    // the inference itself.
+    if (!slot->payload.requested_outputs[idx] ||
+        ((output_buffers[idx] != nullptr) && bound_output.bound)) {
+      continue;
+    }
 
-    ov::Tensor output_tensor = infer_request_.get_tensor(name);
-    std::vector<int64_t> output_shape =
-	    ConvertToSignedShape(output_tensor.get_shape());
+    // A static output is written into the tensor owned by the infer
+    // request, in the shape of its port, so neither has to be asked from
+    // OpenVINO, which returns copies of them. The tensor of a dynamic
+    // output may be replaced by the inference.
+    const ov::Output<const ov::Node>& port = bound_output.port;
+    std::vector<int64_t>& output_shape = slot->payload.shape;
+    ov::Tensor dynamic_tensor;
+    const ov::Tensor* output_tensor = &bound_output.owned;
+    if (port.get_partial_shape().is_static() && !bound_output.bound) {
+      const ov::Shape& port_shape = port.get_shape();
+      output_shape.assign(port_shape.begin(), port_shape.end());
+    } else {
+      RETURN_IF_OPENVINO_ASSIGN_ERROR(
+          dynamic_tensor,
+          slot->request->infer_request.get_tensor(port),
+          std::string("getting request tensor for output ") + name);
+      const ov::Shape tensor_shape = dynamic_tensor.get_shape();
+      output_shape.assign(tensor_shape.begin(), tensor_shape.end());
+      output_tensor = &dynamic_tensor;
+    }
+    RETURN_IF_ERROR(
+        ValidateOutputBatchSize(batch_size, total_batch_size, &output_shape));
+
+    const TRITONSERVER_DataType datatype =
+        ConvertFromOpenVINOElement(output_tensor->get_element_type());
+    if (output_buffers[idx] != nullptr) {
+      memcpy(
+          output_buffers[idx], output_tensor->data(),
+          GetByteSize(datatype, output_shape));
+      copy_output_count_++;
+      continue;
+    }
 
-    responder.ProcessTensor(
-        name,
-        ConvertFromOpenVINOElement(output_tensor.get_element_type()),
-        output_shape, reinterpret_cast<const char*>(output_tensor.data()), TRITONSERVER_MEMORY_CPU, 0);
+    RETURN_IF_ERROR(ScatterOutput(
+        slot, name, datatype, &output_shape,
+        reinterpret_cast<const char*>(output_tensor->data()),
+        output_tensor->get_byte_size()));
+    if (model_state_->EnableZeroCopyOutput()) {
+      copy_output_count_++;
     }
+  }
 
-  // Finalize and wait for any pending buffer copies.
-  cuda_copy |= responder.Finalize();
   return nullptr;
 }
 
 TRITONSERVER_Error*
-ModelInstanceState::ValidateOutputBatchSize(std::vector<int64_t>* output_shape)
+ModelInstanceState::ValidateOutputBatchSize(
+    const size_t batch_size, const size_t total_batch_size,
+    std::vector<int64_t>* output_shape)
 {
   auto mbs = model_state_->MaxBatchSize();
   if (mbs == 0) {
     return nullptr;
   } else if (
-      ((*output_shape)[0] != mbs) &&
-      ((size_t)(*output_shape)[0] != (mbs - batch_pad_size_))) {
+      output_shape->empty() || ((size_t)(*output_shape)[0] != batch_size)) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INTERNAL,
         (std::string(
              "expected the batch size of openvino model output to be ") +
-         std::to_string(mbs) + ", got " + std::to_string((*output_shape)[0]))
+         std::to_string(batch_size) + ", got " +
+         (output_shape->empty() ? std::string("a scalar")
+                                : std::to_string((*output_shape)[0])))
             .c_str());
   }
 
-  (*output_shape)[0] = mbs - batch_pad_size_;
+  // The rows of a padded batch come first, so trimming the shape to the
+  // rows of the requests leaves out the padding without copy.
+  (*output_shape)[0] = total_batch_size;
 
   return nullptr;
 }
@@ -1320,12 +4777,44 @@ TRITONBACKEND_Initialize(TRITONBACKEND_Backend* backend)
             .c_str());
   }
 
+  // The OpenVINO core shared by all the models.
+  BackendState* backend_state;
+  try {
+    backend_state = new BackendState();
+  }
+  catch (const std::exception& error) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("openvino error in creating the core : ") + error.what())
+            .c_str());
+  }
+  TRITONSERVER_Error* err = BackendMetrics::Create(&backend_state->metrics);
+  if (err != nullptr) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_WARN,
+        (std::string("the metrics of the openvino backend are disabled: ") +
+         TRITONSERVER_ErrorMessage(err))
+            .c_str());
+    TRITONSERVER_ErrorDelete(err);
+  }
+  RETURN_IF_ERROR(TRITONBACKEND_BackendSetState(
+      backend, reinterpret_cast<void*>(backend_state)));
+
   return nullptr;  // success
 }
 
 TRITONBACKEND_ISPEC TRITONSERVER_Error*
 TRITONBACKEND_Finalize(TRITONBACKEND_Backend* backend)
 {
+  void* vstate;
+  RETURN_IF_ERROR(TRITONBACKEND_BackendState(backend, &vstate));
+  BackendState* backend_state = reinterpret_cast<BackendState*>(vstate);
+
+  LOG_MESSAGE(
+      TRITONSERVER_LOG_INFO, "TRITONBACKEND_Finalize: delete backend state");
+
+  delete backend_state;
+
   return nullptr;  // success
 }
 
@@ -1448,14 +4937,19 @@ TRITONBACKEND_ModelInstanceExecute(
   // we should not return from this function until execution is
   // complete. Triton will automatically release 'instance' on return
   // from this function so that it is again available to be used for
-  // another call to TRITONBACKEND_ModelInstanceExecute.
+  // another call to TRITONBACKEND_ModelInstanceExecute. When the model
+  // enables asynchronous execution the responses are instead sent from
+  // the completion callback of the infer request, and the next call for
+  // this 'instance' waits for that callback before reusing the request.
 
-  LOG_MESSAGE(
-      TRITONSERVER_LOG_VERBOSE,
-      (std::string("model ") + model_state->Name() + ", instance " +
-       instance_state->Name() + ", executing " + std::to_string(request_count) +
-       " requests")
-          .c_str());
+  if (TRITONSERVER_LogIsEnabled(TRITONSERVER_LOG_VERBOSE)) {
+    LOG_MESSAGE(
+        TRITONSERVER_LOG_VERBOSE,
+        (std::string("model ") + model_state->Name() + ", instance " +
+         instance_state->Name() + ", executing " +
+         std::to_string(request_count) + " requests")
+            .c_str());
+  }
 
   // At this point we accept ownership of 'requests', which means that
   // even if something goes wrong we must still return success from
@@ -0,0 +1,450 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "openvino_metrics.h"
+
+#include "triton/backend/backend_common.h"
+
+namespace triton { namespace backend { namespace openvino {
+
+namespace {
+
+const char* kStageNames[] = {
+    "gather_inputs", "copy_inputs", "infer", "scatter_outputs",
+    "send_responses"};
+
+TRITONSERVER_Error*
+NewMetricFamily(
+    const char* name, const char* description,
+    TRITONSERVER_MetricFamily** family,
+    const TRITONSERVER_MetricKind kind = TRITONSERVER_METRIC_KIND_COUNTER)
+{
+  return TRITONSERVER_MetricFamilyNew(family, kind, name, description);
+}
+
+void
+DeleteMetricFamily(TRITONSERVER_MetricFamily* family)
+{
+  if (family != nullptr) {
+    LOG_IF_ERROR(
+        TRITONSERVER_MetricFamilyDelete(family),
+        "failed to delete metric family");
+  }
+}
+
+// Creates in 'metric' the metric of 'family' with 'labels'.
+TRITONSERVER_Error*
+NewMetric(
+    TRITONSERVER_MetricFamily* family,
+    const std::vector<std::pair<std::string, std::string>>& labels,
+    TRITONSERVER_Metric** metric)
+{
+  std::vector<const TRITONSERVER_Parameter*> parameters;
+  for (const auto& label : labels) {
+    parameters.push_back(TRITONSERVER_ParameterNew(
+        label.first.c_str(), TRITONSERVER_PARAMETER_STRING,
+        label.second.c_str()));
+  }
+  TRITONSERVER_Error* err = TRITONSERVER_MetricNew(
+      metric, family, parameters.data(), parameters.size());
+  for (const auto parameter : parameters) {
+    TRITONSERVER_ParameterDelete(
+        const_cast<TRITONSERVER_Parameter*>(parameter));
+  }
+
+  return err;
+}
+
+void
+DeleteMetric(TRITONSERVER_Metric* metric)
+{
+  if (metric != nullptr) {
+    LOG_IF_ERROR(TRITONSERVER_MetricDelete(metric), "failed to delete metric");
+  }
+}
+
+// The metrics are best effort, failing to update one must not fail the
+// execution nor flood the log.
+void
+IncrementMetric(TRITONSERVER_Metric* metric, const double value)
+{
+  TRITONSERVER_Error* err = TRITONSERVER_MetricIncrement(metric, value);
+  if (err != nullptr) {
+    TRITONSERVER_ErrorDelete(err);
+  }
+}
+
+void
+SetMetric(TRITONSERVER_Metric* metric, const double value)
+{
+  TRITONSERVER_Error* err = TRITONSERVER_MetricSet(metric, value);
+  if (err != nullptr) {
+    TRITONSERVER_ErrorDelete(err);
+  }
+}
+
+}  // namespace
+
+BackendMetrics::BackendMetrics()
+    : stage_duration_us_(nullptr), stage_count_(nullptr),
+      batch_rows_(nullptr), padded_rows_(nullptr), pool_wait_count_(nullptr),
+      pool_wait_duration_us_(nullptr), pool_in_use_(nullptr),
+      cache_hits_(nullptr), cache_misses_(nullptr),
+      cache_import_duration_us_(nullptr), compile_duration_us_(nullptr),
+      perf_count_(nullptr), perf_sampled_count_(nullptr),
+      perf_infer_count_(nullptr)
+{
+}
+
+TRITONSERVER_Error*
+BackendMetrics::Create(std::unique_ptr<BackendMetrics>* metrics)
+{
+  std::unique_ptr<BackendMetrics> backend_metrics(new BackendMetrics());
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_stage_duration_us",
+      "Cumulative time spent in each stage of the executions of the OpenVINO "
+      "backend in microseconds",
+      &backend_metrics->stage_duration_us_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_stage_count",
+      "Number of executions of the OpenVINO backend that went through each "
+      "stage",
+      &backend_metrics->stage_count_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_batch_rows", "Number of batch rows run by the inferences",
+      &backend_metrics->batch_rows_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_padded_rows",
+      "Number of batch rows run by the inferences to pad the batches",
+      &backend_metrics->padded_rows_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_pool_wait_count",
+      "Number of executions that waited for a free infer request",
+      &backend_metrics->pool_wait_count_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_pool_wait_duration_us",
+      "Cumulative time spent by the executions waiting for a free infer "
+      "request in microseconds",
+      &backend_metrics->pool_wait_duration_us_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_pool_in_use",
+      "Number of infer requests of the instance in use by executions",
+      &backend_metrics->pool_in_use_, TRITONSERVER_METRIC_KIND_GAUGE));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_model_cache_hits",
+      "Number of compiled networks imported from the model cache",
+      &backend_metrics->cache_hits_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_model_cache_misses",
+      "Number of networks compiled for lack of an entry in the model cache",
+      &backend_metrics->cache_misses_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_model_cache_import_duration_us",
+      "Cumulative time spent importing compiled networks from the model "
+      "cache in microseconds",
+      &backend_metrics->cache_import_duration_us_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_model_compile_duration_us",
+      "Cumulative time spent compiling networks in microseconds",
+      &backend_metrics->compile_duration_us_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_perf_count",
+      "Cumulative hardware counts of each stage of the executions sampled "
+      "for the hardware counters",
+      &backend_metrics->perf_count_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_perf_sampled_count",
+      "Number of executions sampled for the hardware counters",
+      &backend_metrics->perf_sampled_count_));
+  RETURN_IF_ERROR(NewMetricFamily(
+      "nv_openvino_perf_infer_count",
+      "Cumulative hardware counts of all the threads of the process while "
+      "inferences sampled for the hardware counters run",
+      &backend_metrics->perf_infer_count_));
+
+  *metrics = std::move(backend_metrics);
+  return nullptr;
+}
+
+BackendMetrics::~BackendMetrics()
+{
+  DeleteMetricFamily(stage_duration_us_);
+  DeleteMetricFamily(stage_count_);
+  DeleteMetricFamily(batch_rows_);
+  DeleteMetricFamily(padded_rows_);
+  DeleteMetricFamily(pool_wait_count_);
+  DeleteMetricFamily(pool_wait_duration_us_);
+  DeleteMetricFamily(pool_in_use_);
+  DeleteMetricFamily(cache_hits_);
+  DeleteMetricFamily(cache_misses_);
+  DeleteMetricFamily(cache_import_duration_us_);
+  DeleteMetricFamily(compile_duration_us_);
+  DeleteMetricFamily(perf_count_);
+  DeleteMetricFamily(perf_sampled_count_);
+  DeleteMetricFamily(perf_infer_count_);
+}
+
+ModelMetrics::ModelMetrics()
+    : cache_hits_(nullptr), cache_misses_(nullptr),
+      cache_import_duration_us_(nullptr), compile_duration_us_(nullptr)
+{
+}
+
+TRITONSERVER_Error*
+ModelMetrics::Create(
+    BackendMetrics* backend_metrics, const std::string& model_name,
+    const uint64_t model_version, std::unique_ptr<ModelMetrics>* metrics)
+{
+  const std::vector<std::pair<std::string, std::string>> labels{
+      {"model", model_name}, {"version", std::to_string(model_version)}};
+
+  std::unique_ptr<ModelMetrics> model_metrics(new ModelMetrics());
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->cache_hits_, labels, &model_metrics->cache_hits_));
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->cache_misses_, labels, &model_metrics->cache_misses_));
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->cache_import_duration_us_, labels,
+      &model_metrics->cache_import_duration_us_));
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->compile_duration_us_, labels,
+      &model_metrics->compile_duration_us_));
+
+  *metrics = std::move(model_metrics);
+  return nullptr;
+}
+
+ModelMetrics::~ModelMetrics()
+{
+  DeleteMetric(cache_hits_);
+  DeleteMetric(cache_misses_);
+  DeleteMetric(cache_import_duration_us_);
+  DeleteMetric(compile_duration_us_);
+}
+
+void
+ModelMetrics::CacheHit(const uint64_t import_ns)
+{
+  IncrementMetric(cache_hits_, 1);
+  IncrementMetric(cache_import_duration_us_, import_ns / 1000.0);
+}
+
+void
+ModelMetrics::CacheMiss()
+{
+  IncrementMetric(cache_misses_, 1);
+}
+
+void
+ModelMetrics::ObserveCompile(const uint64_t compile_ns)
+{
+  IncrementMetric(compile_duration_us_, compile_ns / 1000.0);
+}
+
+InstanceMetrics::InstanceMetrics()
+    : batch_rows_(nullptr), padded_rows_(nullptr), pool_wait_count_(nullptr),
+      pool_wait_duration_us_(nullptr), pool_in_use_(nullptr),
+      perf_sampled_count_(nullptr)
+{
+}
+
+TRITONSERVER_Error*
+InstanceMetrics::Create(
+    BackendMetrics* backend_metrics, const std::string& model_name,
+    const uint64_t model_version, const std::string& instance_name,
+    const int numa_node, const bool perf_counters,
+    std::unique_ptr<InstanceMetrics>* metrics)
+{
+  std::vector<std::pair<std::string, std::string>> labels{
+      {"model", model_name},
+      {"version", std::to_string(model_version)},
+      {"instance", instance_name},
+      {"numa_node", (numa_node < 0) ? "none" : std::to_string(numa_node)}};
+
+  std::unique_ptr<InstanceMetrics> instance_metrics(new InstanceMetrics());
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->batch_rows_, labels, &instance_metrics->batch_rows_));
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->padded_rows_, labels, &instance_metrics->padded_rows_));
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->pool_wait_count_, labels,
+      &instance_metrics->pool_wait_count_));
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->pool_wait_duration_us_, labels,
+      &instance_metrics->pool_wait_duration_us_));
+  RETURN_IF_ERROR(NewMetric(
+      backend_metrics->pool_in_use_, labels, &instance_metrics->pool_in_use_));
+  if (perf_counters) {
+    RETURN_IF_ERROR(NewMetric(
+        backend_metrics->perf_sampled_count_, labels,
+        &instance_metrics->perf_sampled_count_));
+  }
+
+  labels.emplace_back("stage", "");
+  for (size_t stage = 0; stage < (size_t)ExecutionStage::COUNT; stage++) {
+    labels.back().second = kStageNames[stage];
+    instance_metrics->stage_duration_us_.push_back(nullptr);
+    RETURN_IF_ERROR(NewMetric(
+        backend_metrics->stage_duration_us_, labels,
+        &instance_metrics->stage_duration_us_.back()));
+    instance_metrics->stage_count_.push_back(nullptr);
+    RETURN_IF_ERROR(NewMetric(
+        backend_metrics->stage_count_, labels,
+        &instance_metrics->stage_count_.back()));
+  }
+
+  if (perf_counters) {
+    labels.emplace_back("counter", "");
+    for (size_t stage = 0; stage < (size_t)PerfStage::COUNT; stage++) {
+      labels[labels.size() - 2].second = PerfStageName((PerfStage)stage);
+      instance_metrics->perf_count_.emplace_back();
+      if (stage == (size_t)PerfStage::INFER) {
+        continue;
+      }
+      for (size_t counter = 0; counter < (size_t)PerfCounter::COUNT;
+           counter++) {
+        labels.back().second = PerfCounterName((PerfCounter)counter);
+        instance_metrics->perf_count_.back().push_back(nullptr);
+        RETURN_IF_ERROR(NewMetric(
+            backend_metrics->perf_count_, labels,
+            &instance_metrics->perf_count_.back().back()));
+      }
+    }
+  }
+
+  *metrics = std::move(instance_metrics);
+  return nullptr;
+}
+
+InstanceMetrics::~InstanceMetrics()
+{
+  for (auto metric : stage_duration_us_) {
+    DeleteMetric(metric);
+  }
+  for (auto metric : stage_count_) {
+    DeleteMetric(metric);
+  }
+  DeleteMetric(batch_rows_);
+  DeleteMetric(padded_rows_);
+  DeleteMetric(pool_wait_count_);
+  DeleteMetric(pool_wait_duration_us_);
+  DeleteMetric(pool_in_use_);
+  for (const auto& stage_metrics : perf_count_) {
+    for (auto metric : stage_metrics) {
+      DeleteMetric(metric);
+    }
+  }
+  DeleteMetric(perf_sampled_count_);
+}
+
+void
+InstanceMetrics::ObserveStage(
+    const ExecutionStage stage, const uint64_t start_ns, const uint64_t end_ns)
+{
+  const size_t index = (size_t)stage;
+  IncrementMetric(
+      stage_duration_us_[index],
+      (end_ns > start_ns) ? (end_ns - start_ns) / 1000.0 : 0);
+  IncrementMetric(stage_count_[index], 1);
+}
+
+void
+InstanceMetrics::ObserveRows(const uint64_t rows, const uint64_t padded_rows)
+{
+  IncrementMetric(batch_rows_, rows);
+  if (padded_rows > 0) {
+    IncrementMetric(padded_rows_, padded_rows);
+  }
+}
+
+void
+InstanceMetrics::ObservePoolWait(const uint64_t wait_ns)
+{
+  IncrementMetric(pool_wait_count_, 1);
+  IncrementMetric(pool_wait_duration_us_, wait_ns / 1000.0);
+}
+
+void
+InstanceMetrics::SetPoolInUse(const uint64_t in_use)
+{
+  SetMetric(pool_in_use_, in_use);
+}
+
+void
+InstanceMetrics::ObservePerfCounts(
+    const std::array<PerfCounts, (size_t)PerfStage::COUNT>& counts)
+{
+  if (perf_sampled_count_ == nullptr) {
+    return;
+  }
+  IncrementMetric(perf_sampled_count_, 1);
+  for (size_t stage = 0; stage < perf_count_.size(); stage++) {
+    for (size_t counter = 0; counter < perf_count_[stage].size();
+         counter++) {
+      IncrementMetric(perf_count_[stage][counter], counts[stage][counter]);
+    }
+  }
+}
+
+ProcessPerfMetrics::ProcessPerfMetrics() {}
+
+TRITONSERVER_Error*
+ProcessPerfMetrics::Create(
+    BackendMetrics* backend_metrics,
+    std::unique_ptr<ProcessPerfMetrics>* metrics)
+{
+  std::vector<std::pair<std::string, std::string>> labels{{"counter", ""}};
+
+  std::unique_ptr<ProcessPerfMetrics> process_metrics(
+      new ProcessPerfMetrics());
+  for (size_t counter = 0; counter < (size_t)PerfCounter::COUNT; counter++) {
+    labels.back().second = PerfCounterName((PerfCounter)counter);
+    process_metrics->perf_infer_count_.push_back(nullptr);
+    RETURN_IF_ERROR(NewMetric(
+        backend_metrics->perf_infer_count_, labels,
+        &process_metrics->perf_infer_count_.back()));
+  }
+
+  *metrics = std::move(process_metrics);
+  return nullptr;
+}
+
+ProcessPerfMetrics::~ProcessPerfMetrics()
+{
+  for (auto metric : perf_infer_count_) {
+    DeleteMetric(metric);
+  }
+}
+
+void
+ProcessPerfMetrics::ObservePerfCounts(const PerfCounts& counts)
+{
+  for (size_t counter = 0; counter < perf_infer_count_.size(); counter++) {
+    IncrementMetric(perf_infer_count_[counter], counts[counter]);
+  }
+}
+
+}}}  // namespace triton::backend::openvino
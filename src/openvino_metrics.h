@@ -0,0 +1,173 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "openvino_perf_counters.h"
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace backend { namespace openvino {
+
+// The stages of an execution whose durations are exported.
+enum class ExecutionStage {
+  // Creating the responses and gathering the inputs of the requests.
+  GATHER_INPUTS,
+  // Copying the gathered inputs into the tensors of the infer request.
+  COPY_INPUTS,
+  // Running the inference.
+  INFER,
+  // Scattering the outputs of the infer request into the responses.
+  SCATTER_OUTPUTS,
+  // Sending the responses and releasing the requests.
+  SEND_RESPONSES,
+  COUNT
+};
+
+// The metric families of the backend, registered with Triton so that
+// the metrics of the models and their instances appear on its metrics
+// endpoint. Created once by the backend, as a family can only be
+// registered once, and deleted after all the models.
+class BackendMetrics {
+ public:
+  static TRITONSERVER_Error* Create(std::unique_ptr<BackendMetrics>* metrics);
+  ~BackendMetrics();
+
+ private:
+  friend class ModelMetrics;
+  friend class InstanceMetrics;
+  friend class ProcessPerfMetrics;
+  BackendMetrics();
+
+  TRITONSERVER_MetricFamily* stage_duration_us_;
+  TRITONSERVER_MetricFamily* stage_count_;
+  TRITONSERVER_MetricFamily* batch_rows_;
+  TRITONSERVER_MetricFamily* padded_rows_;
+  TRITONSERVER_MetricFamily* pool_wait_count_;
+  TRITONSERVER_MetricFamily* pool_wait_duration_us_;
+  TRITONSERVER_MetricFamily* pool_in_use_;
+  TRITONSERVER_MetricFamily* cache_hits_;
+  TRITONSERVER_MetricFamily* cache_misses_;
+  TRITONSERVER_MetricFamily* cache_import_duration_us_;
+  TRITONSERVER_MetricFamily* compile_duration_us_;
+  TRITONSERVER_MetricFamily* perf_count_;
+  TRITONSERVER_MetricFamily* perf_sampled_count_;
+  TRITONSERVER_MetricFamily* perf_infer_count_;
+};
+
+// The metrics of a model, labelled by model and version.
+class ModelMetrics {
+ public:
+  static TRITONSERVER_Error* Create(
+      BackendMetrics* backend_metrics, const std::string& model_name,
+      const uint64_t model_version, std::unique_ptr<ModelMetrics>* metrics);
+  ~ModelMetrics();
+
+  // Counts a compiled network imported from the model cache in
+  // 'import_ns', or compiled for lack of an entry.
+  void CacheHit(const uint64_t import_ns);
+  void CacheMiss();
+  // Accounts for a network compiled in 'compile_ns', cached or not.
+  void ObserveCompile(const uint64_t compile_ns);
+
+ private:
+  ModelMetrics();
+
+  TRITONSERVER_Metric* cache_hits_;
+  TRITONSERVER_Metric* cache_misses_;
+  TRITONSERVER_Metric* cache_import_duration_us_;
+  TRITONSERVER_Metric* compile_duration_us_;
+};
+
+// The metrics of a model instance, labelled by model, version, instance
+// and the NUMA node the instance is placed on. The metrics of the
+// hardware counters only exist if 'perf_counters' is set, for the stages
+// other than the inference, which is counted by ProcessPerfMetrics.
+class InstanceMetrics {
+ public:
+  static TRITONSERVER_Error* Create(
+      BackendMetrics* backend_metrics, const std::string& model_name,
+      const uint64_t model_version, const std::string& instance_name,
+      const int numa_node, const bool perf_counters,
+      std::unique_ptr<InstanceMetrics>* metrics);
+  ~InstanceMetrics();
+
+  // Accounts for a stage of an execution from 'start_ns' to 'end_ns'.
+  void ObserveStage(
+      const ExecutionStage stage, const uint64_t start_ns,
+      const uint64_t end_ns);
+  // Accounts for the rows run by an execution, of which 'padded_rows'
+  // pad the batch.
+  void ObserveRows(const uint64_t rows, const uint64_t padded_rows);
+  // Accounts for an execution that waited 'wait_ns' for an infer request.
+  void ObservePoolWait(const uint64_t wait_ns);
+  // Sets the number of infer requests of the instance in use.
+  void SetPoolInUse(const uint64_t in_use);
+  // Accounts for the counts of each stage of a sampled execution, but
+  // the inference.
+  void ObservePerfCounts(
+      const std::array<PerfCounts, (size_t)PerfStage::COUNT>& counts);
+
+ private:
+  InstanceMetrics();
+
+  std::vector<TRITONSERVER_Metric*> stage_duration_us_;
+  std::vector<TRITONSERVER_Metric*> stage_count_;
+  TRITONSERVER_Metric* batch_rows_;
+  TRITONSERVER_Metric* padded_rows_;
+  TRITONSERVER_Metric* pool_wait_count_;
+  TRITONSERVER_Metric* pool_wait_duration_us_;
+  TRITONSERVER_Metric* pool_in_use_;
+  // By stage then counter.
+  std::vector<std::vector<TRITONSERVER_Metric*>> perf_count_;
+  TRITONSERVER_Metric* perf_sampled_count_;
+};
+
+// The hardware counts of all the threads of the process while sampled
+// inferences run, labelled by counter only, as they can't be told apart
+// by model or instance.
+class ProcessPerfMetrics {
+ public:
+  static TRITONSERVER_Error* Create(
+      BackendMetrics* backend_metrics,
+      std::unique_ptr<ProcessPerfMetrics>* metrics);
+  ~ProcessPerfMetrics();
+
+  void ObservePerfCounts(const PerfCounts& counts);
+
+ private:
+  ProcessPerfMetrics();
+
+  std::vector<TRITONSERVER_Metric*> perf_infer_count_;
+};
+
+}}}  // namespace triton::backend::openvino
@@ -0,0 +1,359 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "openvino_perf_counters.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <set>
+#include <string>
+
+#include "triton/backend/backend_common.h"
+
+namespace triton { namespace backend { namespace openvino {
+
+namespace {
+
+const char* kStageNames[] = {"inputs", "infer", "outputs"};
+const char* kCounterNames[] = {
+    "cycles", "instructions", "llc_misses", "context_switches"};
+
+#ifdef __linux__
+// The hardware counters of a group, in the order of PerfCounter.
+const uint64_t kHardwareEvents[] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES};
+constexpr size_t kHardwareEventCount =
+    sizeof(kHardwareEvents) / sizeof(kHardwareEvents[0]);
+
+// The threads of the process are looked up at most this often.
+constexpr uint64_t kRefreshIntervalNs = 1000000000ULL;
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#else
+TRITONSERVER_Error*
+Unsupported()
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "hardware counters are only supported on Linux");
+}
+#endif  // __linux__
+
+}  // namespace
+
+const char*
+PerfStageName(const PerfStage stage)
+{
+  return kStageNames[(size_t)stage];
+}
+
+const char*
+PerfCounterName(const PerfCounter counter)
+{
+  return kCounterNames[(size_t)counter];
+}
+
+PerfWindow::PerfWindow(PerfCounters* counters)
+    : counters_(counters), open_count_(0)
+{
+  start_.fill(0);
+}
+
+TRITONSERVER_Error*
+PerfWindow::Enter()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  if (open_count_ == 0) {
+    // No period is being measured, so the threads can be refreshed.
+    RETURN_IF_ERROR(counters_->Refresh());
+    RETURN_IF_ERROR(counters_->Read(&start_));
+  }
+  open_count_++;
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+PerfWindow::Leave(PerfCounts* counts)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  counts->fill(0);
+  if (--open_count_ > 0) {
+    return nullptr;
+  }
+
+  RETURN_IF_ERROR(counters_->Read(counts));
+  for (size_t counter = 0; counter < counts->size(); counter++) {
+    // The scaled counts of multiplexed counters may go slightly back.
+    (*counts)[counter] = ((*counts)[counter] > start_[counter])
+                             ? (*counts)[counter] - start_[counter]
+                             : 0;
+  }
+
+  return nullptr;
+}
+
+#ifndef __linux__
+PerfCounters::PerfCounters(const bool process)
+    : process_(process), refresh_ns_(0), base_context_switches_(0)
+{
+  retired_.fill(0);
+}
+
+PerfCounters::~PerfCounters() {}
+
+TRITONSERVER_Error*
+PerfCounters::CreateForThread(std::unique_ptr<PerfCounters>* counters)
+{
+  return Unsupported();
+}
+
+TRITONSERVER_Error*
+PerfCounters::CreateForProcess(std::unique_ptr<PerfCounters>* counters)
+{
+  return Unsupported();
+}
+
+TRITONSERVER_Error*
+PerfCounters::Read(PerfCounts* counts)
+{
+  return Unsupported();
+}
+
+TRITONSERVER_Error*
+PerfCounters::Refresh()
+{
+  return Unsupported();
+}
+#else
+PerfCounters::PerfCounters(const bool process)
+    : process_(process), refresh_ns_(0), base_context_switches_(0)
+{
+  retired_.fill(0);
+}
+
+PerfCounters::~PerfCounters()
+{
+  for (const auto& group : groups_) {
+    for (const int fd : group.second) {
+      close(fd);
+    }
+  }
+}
+
+TRITONSERVER_Error*
+PerfCounters::CreateForThread(std::unique_ptr<PerfCounters>* counters)
+{
+  std::unique_ptr<PerfCounters> perf_counters(new PerfCounters(false));
+  RETURN_IF_ERROR(perf_counters->OpenThread(syscall(SYS_gettid)));
+  perf_counters->base_context_switches_ = perf_counters->ContextSwitches();
+
+  *counters = std::move(perf_counters);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+PerfCounters::CreateForProcess(std::unique_ptr<PerfCounters>* counters)
+{
+  std::unique_ptr<PerfCounters> perf_counters(new PerfCounters(true));
+  // Fail here rather than on read if the counters can't be opened.
+  RETURN_IF_ERROR(perf_counters->OpenThread(syscall(SYS_gettid)));
+  RETURN_IF_ERROR(perf_counters->RefreshThreads());
+  perf_counters->base_context_switches_ = perf_counters->ContextSwitches();
+
+  *counters = std::move(perf_counters);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+PerfCounters::OpenThread(const int tid)
+{
+  std::vector<int> fds;
+  for (size_t e = 0; e < kHardwareEventCount; e++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = kHardwareEvents[e];
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    const int fd = syscall(
+        __NR_perf_event_open, &attr, tid, -1 /* cpu */,
+        fds.empty() ? -1 : fds[0], PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0) {
+      const int error = errno;
+      for (const int opened : fds) {
+        close(opened);
+      }
+      // The thread exited meanwhile.
+      if (error == ESRCH) {
+        return nullptr;
+      }
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNAVAILABLE,
+          (std::string("unable to open the hardware counters of thread ") +
+           std::to_string(tid) + ": " + strerror(error) +
+           (((error == EACCES) || (error == EPERM))
+                ? ", see /proc/sys/kernel/perf_event_paranoid"
+                : ""))
+              .c_str());
+    }
+    fds.push_back(fd);
+  }
+  groups_[tid] = std::move(fds);
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+PerfCounters::RefreshThreads()
+{
+  std::set<int> tids;
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("unable to list the threads of the process: ") +
+         strerror(errno))
+            .c_str());
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      tids.insert(atoi(entry->d_name));
+    }
+  }
+  closedir(dir);
+
+  for (auto it = groups_.begin(); it != groups_.end();) {
+    if (tids.find(it->first) != tids.end()) {
+      ++it;
+      continue;
+    }
+    // The counts of an exited thread remain readable until closed.
+    LOG_IF_ERROR(
+        ReadGroup(it->second, &retired_),
+        "failed to read the counters of an exited thread");
+    for (const int fd : it->second) {
+      close(fd);
+    }
+    it = groups_.erase(it);
+  }
+  for (const int tid : tids) {
+    if (groups_.find(tid) == groups_.end()) {
+      RETURN_IF_ERROR(OpenThread(tid));
+    }
+  }
+  refresh_ns_ = NowNs();
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+PerfCounters::ReadGroup(const std::vector<int>& fds, PerfCounts* counts)
+{
+  // The number of counters, the times the group was enabled and running,
+  // then the counts.
+  uint64_t data[3 + kHardwareEventCount];
+  const ssize_t size = read(fds[0], data, sizeof(data));
+  if (size != (ssize_t)sizeof(data)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("unable to read the hardware counters: ") +
+         ((size < 0) ? strerror(errno) : "short read"))
+            .c_str());
+  }
+
+  // Scale the counts up for the time the group wasn't scheduled on the
+  // CPU, when there are more counters than the CPU has.
+  const uint64_t enabled = data[1];
+  const uint64_t running = data[2];
+  if (running == 0) {
+    return nullptr;
+  }
+  for (size_t e = 0; e < kHardwareEventCount; e++) {
+    (*counts)[e] += (running < enabled)
+                        ? (uint64_t)((double)data[3 + e] * enabled / running)
+                        : data[3 + e];
+  }
+
+  return nullptr;
+}
+
+uint64_t
+PerfCounters::ContextSwitches()
+{
+  struct rusage usage;
+  if (getrusage(process_ ? RUSAGE_SELF : RUSAGE_THREAD, &usage) != 0) {
+    return 0;
+  }
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+TRITONSERVER_Error*
+PerfCounters::Read(PerfCounts* counts)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  *counts = retired_;
+  for (const auto& group : groups_) {
+    RETURN_IF_ERROR(ReadGroup(group.second, counts));
+  }
+  (*counts)[(size_t)PerfCounter::CONTEXT_SWITCHES] =
+      ContextSwitches() - base_context_switches_;
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+PerfCounters::Refresh()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  if (process_ && ((NowNs() - refresh_ns_) >= kRefreshIntervalNs)) {
+    RETURN_IF_ERROR(RefreshThreads());
+  }
+
+  return nullptr;
+}
+#endif  // __linux__
+
+}}}  // namespace triton::backend::openvino
@@ -0,0 +1,136 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace backend { namespace openvino {
+
+// The counters read around the stages of an execution.
+enum class PerfCounter {
+  CYCLES,
+  INSTRUCTIONS,
+  // The last level cache misses, as counted by the CPU for the generic
+  // cache misses event.
+  LLC_MISSES,
+  CONTEXT_SWITCHES,
+  COUNT
+};
+typedef std::array<uint64_t, (size_t)PerfCounter::COUNT> PerfCounts;
+
+// The stages of an execution the counters are read around.
+enum class PerfStage {
+  // Gathering the inputs of the requests and copying them into the
+  // infer request, on the thread of the execution.
+  INPUTS,
+  // Running the inference, on all the threads of the process, counted
+  // for the process rather than for the execution, see PerfWindow.
+  INFER,
+  // Scattering the outputs of the infer request into the responses, on
+  // the thread of the execution.
+  OUTPUTS,
+  COUNT
+};
+
+const char* PerfStageName(const PerfStage stage);
+const char* PerfCounterName(const PerfCounter counter);
+
+// Hardware counters opened with perf_event_open, in user space only so
+// that they don't require privileges beyond the default
+// perf_event_paranoid, along with the context switches from getrusage.
+// The counts are since the counters were opened. Only supported on
+// Linux, elsewhere the counters fail to open with UNSUPPORTED.
+class PerfCounters {
+ public:
+  // Opens the counters of the calling thread, to be read by it.
+  static TRITONSERVER_Error* CreateForThread(
+      std::unique_ptr<PerfCounters>* counters);
+  // Opens the counters of all the threads of the process. Can be read
+  // from any thread.
+  static TRITONSERVER_Error* CreateForProcess(
+      std::unique_ptr<PerfCounters>* counters);
+  ~PerfCounters();
+
+  TRITONSERVER_Error* Read(PerfCounts* counts);
+  // Opens the counters of the threads of the process started since the
+  // last refresh, if that was long enough ago, and retires those of the
+  // threads exited. The threads opened only count from the refresh on,
+  // so refresh outside of the periods measured.
+  TRITONSERVER_Error* Refresh();
+
+ private:
+  explicit PerfCounters(const bool process);
+
+  // Opens the hardware counters of thread 'tid' as a group.
+  TRITONSERVER_Error* OpenThread(const int tid);
+  // Opens the counters of the threads started since the last refresh and
+  // retires those of the threads exited.
+  TRITONSERVER_Error* RefreshThreads();
+  // Adds the counts of the group 'fds' to 'counts'.
+  TRITONSERVER_Error* ReadGroup(
+      const std::vector<int>& fds, PerfCounts* counts);
+  uint64_t ContextSwitches();
+
+  const bool process_;
+  std::mutex mu_;
+  // The hardware counters of each thread, the leader of the group first.
+  std::map<int, std::vector<int>> groups_;
+  // The counts of the threads that exited.
+  PerfCounts retired_;
+  uint64_t refresh_ns_;
+  uint64_t base_context_switches_;
+};
+
+// The counts of the process over the periods during which at least one
+// window is open, so that overlapping windows, such as the concurrent
+// inferences of several instances, are counted once.
+class PerfWindow {
+ public:
+  explicit PerfWindow(PerfCounters* counters);
+
+  // Opens a window, reading the counters if it is the only one open.
+  TRITONSERVER_Error* Enter();
+  // Closes a window, returning in 'counts' the counts since the windows
+  // were first open if it was the last one open, or zeros otherwise.
+  TRITONSERVER_Error* Leave(PerfCounts* counts);
+
+ private:
+  PerfCounters* counters_;
+  std::mutex mu_;
+  size_t open_count_;
+  PerfCounts start_;
+};
+
+}}}  // namespace triton::backend::openvino
@@ -0,0 +1,214 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "openvino_trace.h"
+
+#include <string.h>
+
+#include "triton/backend/backend_common.h"
+
+namespace triton { namespace backend { namespace openvino {
+
+namespace {
+
+const char kTraceMagic[8] = {'O', 'V', 'T', 'R', 'A', 'C', 'E', '1'};
+
+template <typename T>
+void
+AppendNumber(const T value, std::string* buffer)
+{
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void
+AppendString(const std::string& str, std::string* buffer)
+{
+  AppendNumber<uint32_t>(str.size(), buffer);
+  buffer->append(str);
+}
+
+}  // namespace
+
+TRITONSERVER_Error*
+TraceWriter::Create(
+    const std::string& path, const std::string& model_name,
+    const uint64_t model_version, std::unique_ptr<TraceWriter>* writer)
+{
+  std::unique_ptr<TraceWriter> trace_writer(new TraceWriter(path));
+  trace_writer->file_.open(path, std::ios::binary | std::ios::trunc);
+
+  std::string header(kTraceMagic, sizeof(kTraceMagic));
+  AppendString(model_name, &header);
+  AppendNumber(model_version, &header);
+  trace_writer->file_.write(header.data(), header.size());
+  trace_writer->file_.flush();
+  if (!trace_writer->file_) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("failed to create the trace file '") + path + "'")
+            .c_str());
+  }
+
+  *writer = std::move(trace_writer);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TraceWriter::Write(const TraceExecution& execution)
+{
+  // Serialize the execution first so that the executions written from
+  // several threads don't interleave.
+  std::string buffer;
+  AppendNumber(execution.start_ns, &buffer);
+  AppendNumber(execution.end_ns, &buffer);
+  AppendString(execution.instance, &buffer);
+  AppendNumber<uint32_t>(execution.requests.size(), &buffer);
+  for (const auto& request : execution.requests) {
+    AppendNumber<uint32_t>(request.inputs.size(), &buffer);
+    for (const auto& input : request.inputs) {
+      AppendString(input.name, &buffer);
+      AppendNumber<uint32_t>(input.datatype, &buffer);
+      AppendNumber<uint32_t>(input.shape.size(), &buffer);
+      for (const auto dim : input.shape) {
+        AppendNumber<int64_t>(dim, &buffer);
+      }
+      AppendNumber<uint64_t>(input.data.size(), &buffer);
+      buffer.append(input.data.data(), input.data.size());
+    }
+    AppendNumber<uint32_t>(request.requested_outputs.size(), &buffer);
+    for (const auto& name : request.requested_outputs) {
+      AppendString(name, &buffer);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mu_);
+  file_.write(buffer.data(), buffer.size());
+  file_.flush();
+  if (!file_) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("failed to write to the trace file '") + path_ + "'")
+            .c_str());
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TraceReader::Create(
+    const std::string& path, std::unique_ptr<TraceReader>* reader)
+{
+  std::unique_ptr<TraceReader> trace_reader(new TraceReader(path));
+  trace_reader->file_.open(path, std::ios::binary);
+  if (!trace_reader->file_) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_NOT_FOUND,
+        (std::string("failed to open the trace file '") + path + "'").c_str());
+  }
+
+  char magic[sizeof(kTraceMagic)];
+  RETURN_IF_ERROR(trace_reader->ReadBytes(magic, sizeof(magic)));
+  if (memcmp(magic, kTraceMagic, sizeof(magic)) != 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("'") + path + "' is not a trace file").c_str());
+  }
+  RETURN_IF_ERROR(trace_reader->ReadString(&trace_reader->model_name_));
+  RETURN_IF_ERROR(trace_reader->ReadNumber(&trace_reader->model_version_));
+
+  *reader = std::move(trace_reader);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TraceReader::Read(TraceExecution* execution, bool* done)
+{
+  // The trace ends where an execution would start.
+  *done = (file_.peek() == std::ifstream::traits_type::eof());
+  if (*done) {
+    return nullptr;
+  }
+
+  RETURN_IF_ERROR(ReadNumber(&execution->start_ns));
+  RETURN_IF_ERROR(ReadNumber(&execution->end_ns));
+  RETURN_IF_ERROR(ReadString(&execution->instance));
+  uint32_t request_count;
+  RETURN_IF_ERROR(ReadNumber(&request_count));
+  execution->requests.resize(request_count);
+  for (auto& request : execution->requests) {
+    uint32_t input_count;
+    RETURN_IF_ERROR(ReadNumber(&input_count));
+    request.inputs.resize(input_count);
+    for (auto& input : request.inputs) {
+      RETURN_IF_ERROR(ReadString(&input.name));
+      uint32_t datatype;
+      RETURN_IF_ERROR(ReadNumber(&datatype));
+      input.datatype = static_cast<TRITONSERVER_DataType>(datatype);
+      uint32_t dims_count;
+      RETURN_IF_ERROR(ReadNumber(&dims_count));
+      input.shape.resize(dims_count);
+      for (auto& dim : input.shape) {
+        RETURN_IF_ERROR(ReadNumber(&dim));
+      }
+      uint64_t data_size;
+      RETURN_IF_ERROR(ReadNumber(&data_size));
+      input.data.resize(data_size);
+      RETURN_IF_ERROR(ReadBytes(input.data.data(), data_size));
+    }
+    uint32_t output_count;
+    RETURN_IF_ERROR(ReadNumber(&output_count));
+    request.requested_outputs.resize(output_count);
+    for (auto& name : request.requested_outputs) {
+      RETURN_IF_ERROR(ReadString(&name));
+    }
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TraceReader::ReadBytes(void* data, const size_t size)
+{
+  file_.read(reinterpret_cast<char*>(data), size);
+  if (!file_) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("the trace file '") + path_ + "' is truncated").c_str());
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TraceReader::ReadString(std::string* str)
+{
+  uint32_t size;
+  RETURN_IF_ERROR(ReadNumber(&size));
+  str->resize(size);
+  return ReadBytes(&(*str)[0], size);
+}
+
+}}}  // namespace triton::backend::openvino
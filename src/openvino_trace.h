@@ -0,0 +1,118 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "triton/core/tritonserver.h"
+
+namespace triton { namespace backend { namespace openvino {
+
+// The executions of a model captured in a trace, to reproduce them
+// offline. The trace file starts with a header of
+//   char[8] "OVTRACE1", string model_name, uint64 model_version
+// followed by the executions, each of
+//   uint64 start_ns, uint64 end_ns, string instance, uint32 request_count
+// and for each request
+//   uint32 input_count, and for each input
+//     string name, uint32 datatype, uint32 dims_count,
+//     int64 dims[dims_count], uint64 data_size, char data[data_size]
+//   uint32 output_count, string output_names[output_count]
+// where a string is a uint32 length followed by its chars. The numbers
+// are in the byte order of the host. The data of the inputs is empty
+// unless it was captured.
+
+struct TraceInput {
+  std::string name;
+  TRITONSERVER_DataType datatype;
+  std::vector<int64_t> shape;
+  std::vector<char> data;
+};
+
+struct TraceRequest {
+  std::vector<TraceInput> inputs;
+  std::vector<std::string> requested_outputs;
+};
+
+struct TraceExecution {
+  uint64_t start_ns;
+  uint64_t end_ns;
+  std::string instance;
+  std::vector<TraceRequest> requests;
+};
+
+// Appends executions to a trace file, from any thread.
+class TraceWriter {
+ public:
+  // Creates the trace file at 'path', replacing any existing one.
+  static TRITONSERVER_Error* Create(
+      const std::string& path, const std::string& model_name,
+      const uint64_t model_version, std::unique_ptr<TraceWriter>* writer);
+
+  TRITONSERVER_Error* Write(const TraceExecution& execution);
+
+ private:
+  explicit TraceWriter(const std::string& path) : path_(path) {}
+
+  const std::string path_;
+  std::mutex mu_;
+  std::ofstream file_;
+};
+
+class TraceReader {
+ public:
+  static TRITONSERVER_Error* Create(
+      const std::string& path, std::unique_ptr<TraceReader>* reader);
+
+  const std::string& ModelName() const { return model_name_; }
+  uint64_t ModelVersion() const { return model_version_; }
+
+  // Reads the next execution of the trace, or sets 'done' at its end.
+  TRITONSERVER_Error* Read(TraceExecution* execution, bool* done);
+
+ private:
+  explicit TraceReader(const std::string& path) : path_(path) {}
+
+  TRITONSERVER_Error* ReadBytes(void* data, const size_t size);
+  template <typename T>
+  TRITONSERVER_Error* ReadNumber(T* value)
+  {
+    return ReadBytes(value, sizeof(T));
+  }
+  TRITONSERVER_Error* ReadString(std::string* str);
+
+  const std::string path_;
+  std::ifstream file_;
+  std::string model_name_;
+  uint64_t model_version_;
+};
+
+}}}  // namespace triton::backend::openvino
@@ -26,6 +26,26 @@
 
 #include "openvino_utils.h"
 
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <direct.h>
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
 #include "triton/backend/backend_common.h"
 
 namespace triton { namespace backend { namespace openvino {
@@ -198,20 +218,26 @@ OpenVINOElementToModelConfigDataType(const ov::element::Type& data_type)
 TRITONSERVER_Error*
 CompareDimsSupported(
     const std::string& model_name, const std::string& tensor_name,
-    const std::vector<size_t>& model_shape, const std::vector<int64_t>& dims,
+    const ov::PartialShape& model_shape, const std::vector<int64_t>& dims,
     const int max_batch_size, const bool compare_exact)
 {
-  // TODO: OpenVINO backend does not support the dynamic shapes as of now.
-  // We can use RESIZE_BILINEAR preProcess in InputInfo to support dynamic
-  // shapes in future.
-  for (const auto& dim : dims) {
-    RETURN_ERROR_IF_TRUE(
-        (dim == -1), TRITONSERVER_ERROR_INVALID_ARG,
-        std::string("model '") + model_name + "', tensor '" + tensor_name +
-            "': provides -1 dim (shape " + ShapeToString(dims) +
-            "), openvino "
-            "currently does not support dynamic shapes.");
+  // A -1 dim of the configuration is variable, the model is reshaped to
+  // make it dynamic, and a dynamic dimension of the model takes any size,
+  // so either matches any dimension. A model of dynamic rank takes any
+  // shape.
+  if (model_shape.rank().is_dynamic()) {
+    return nullptr;
   }
+  auto dims_match = [&model_shape](
+                        const std::vector<int64_t>& config_dims,
+                        const size_t first) {
+    bool succ = (model_shape.size() == config_dims.size());
+    for (size_t i = first; succ && (i < config_dims.size()); ++i) {
+      succ &= (config_dims[i] == -1) || model_shape[i].is_dynamic() ||
+              (model_shape[i].get_length() == config_dims[i]);
+    }
+    return succ;
+  };
 
   // If the model configuration expects batching support in the model,
   // then the openvino first dimension will be reshaped hence should not
@@ -229,22 +255,12 @@ CompareDimsSupported(
     full_dims.push_back(max_batch_size);
     full_dims.insert(full_dims.end(), dims.begin(), dims.end());
 
-    bool succ = (model_shape.size() == (size_t)full_dims.size());
-    if (succ) {
-      for (size_t i = 0; i < full_dims.size(); ++i) {
-        const int64_t model_dim = model_shape[i];
-        if (compare_exact || (i != 0)) {
-          succ &= (model_dim == full_dims[i]);
-        }
-      }
-    }
-
     RETURN_ERROR_IF_TRUE(
-        !succ, TRITONSERVER_ERROR_INVALID_ARG,
+        !dims_match(full_dims, compare_exact ? 0 : 1),
+        TRITONSERVER_ERROR_INVALID_ARG,
         std::string("model '") + model_name + "', tensor '" + tensor_name +
             "': the model expects " + std::to_string(model_shape.size()) +
-            " dimensions (shape " +
-            ShapeToString(ConvertToSignedShape(model_shape)) +
+            " dimensions (shape " + model_shape.to_string() +
             ") but the model configuration specifies " +
             std::to_string(full_dims.size()) +
             " dimensions (an initial batch dimension because max_batch_size "
@@ -253,20 +269,11 @@ CompareDimsSupported(
             ShapeToString(full_dims) + ")");
   } else {
     // ! supports_batching
-    bool succ = (model_shape.size() == dims.size());
-    if (succ) {
-      for (size_t i = 0; i < dims.size(); ++i) {
-        const int64_t model_dim = model_shape[i];
-        succ &= (model_dim == dims[i]);
-      }
-    }
-
     RETURN_ERROR_IF_TRUE(
-        !succ, TRITONSERVER_ERROR_INVALID_ARG,
+        !dims_match(dims, 0), TRITONSERVER_ERROR_INVALID_ARG,
         std::string("model '") + model_name + "', tensor '" + tensor_name +
             "': the model expects " + std::to_string(model_shape.size()) +
-            " dimensions (shape " +
-            ShapeToString(ConvertToSignedShape(model_shape)) +
+            " dimensions (shape " + model_shape.to_string() +
             ") but the model configuration specifies " +
             std::to_string(dims.size()) + " dimensions (shape " +
             ShapeToString(dims) + ")");
@@ -294,4 +301,314 @@ ConvertToSignedShape(const std::vector<size_t> shape)
   return std::vector<int64_t>{shape.begin(), shape.end()};
 }
 
+bool
+IsCompatibleShape(const ov::PartialShape& partial_shape, const ov::Shape& shape)
+{
+  if (partial_shape.rank().is_dynamic()) {
+    return true;
+  }
+  if (partial_shape.size() != shape.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < shape.size(); i++) {
+    if (!partial_shape[i].compatible((int64_t)shape[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TRITONSERVER_Error*
+ReadNumaNodes(std::map<int, std::vector<int>>* node_cpus)
+{
+  node_cpus->clear();
+#ifndef __linux__
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "NUMA placement is only supported on Linux");
+#else
+  const std::string node_dir = "/sys/devices/system/node";
+  DIR* dir = opendir(node_dir.c_str());
+  if (dir == nullptr) {
+    return nullptr;
+  }
+
+  TRITONSERVER_Error* err = nullptr;
+  struct dirent* entry;
+  while ((err == nullptr) && ((entry = readdir(dir)) != nullptr)) {
+    int node;
+    char trailing;
+    if (sscanf(entry->d_name, "node%d%c", &node, &trailing) != 1) {
+      continue;
+    }
+    std::ifstream file(
+        node_dir + "/" + entry->d_name + "/cpulist", std::ios::in);
+    std::string cpu_list;
+    if (!file.is_open() || !std::getline(file, cpu_list)) {
+      continue;
+    }
+    std::vector<int> cpus;
+    err = ParseCpuList(cpu_list, &cpus);
+    // Nodes without CPUs, such as memory-only nodes, run nothing.
+    if ((err == nullptr) && !cpus.empty()) {
+      (*node_cpus)[node] = cpus;
+    }
+  }
+  closedir(dir);
+
+  return err;
+#endif  // __linux__
+}
+
+TRITONSERVER_Error*
+ParseCpuList(const std::string& cpu_list, std::vector<int>* cpus)
+{
+  cpus->clear();
+  std::stringstream ss(cpu_list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    range.erase(0, range.find_first_not_of(" \n"));
+    range.erase(range.find_last_not_of(" \n") + 1);
+    if (range.empty()) {
+      continue;
+    }
+    int first, last;
+    char trailing;
+    const int count =
+        sscanf(range.c_str(), "%d-%d%c", &first, &last, &trailing);
+    if (count == 1) {
+      last = first;
+    }
+    RETURN_ERROR_IF_TRUE(
+        ((count != 1) && (count != 2)) || (first < 0) || (last < first),
+        TRITONSERVER_ERROR_INTERNAL,
+        std::string("unexpected CPU list '") + cpu_list + "'");
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus->push_back(cpu);
+    }
+  }
+
+  return nullptr;
+}
+
+#ifdef __linux__
+struct ScopedThreadAffinity::SavedAffinity {
+  cpu_set_t cpus;
+};
+
+TRITONSERVER_Error*
+SetThreadAffinity(const std::vector<int>& cpus)
+{
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (const int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &mask);
+    }
+  }
+  RETURN_ERROR_IF_TRUE(
+      sched_setaffinity(0 /* calling thread */, sizeof(mask), &mask) != 0,
+      TRITONSERVER_ERROR_INTERNAL,
+      std::string("unable to set the CPU affinity of the thread: ") +
+          strerror(errno));
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+GetThreadAffinity(const int tid, std::vector<int>* cpus)
+{
+  cpus->clear();
+  cpu_set_t mask;
+  RETURN_ERROR_IF_TRUE(
+      sched_getaffinity(tid, sizeof(mask), &mask) != 0,
+      TRITONSERVER_ERROR_INTERNAL,
+      std::string("unable to get the CPU affinity of thread ") +
+          std::to_string(tid) + ": " + strerror(errno));
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &mask)) {
+      cpus->push_back(cpu);
+    }
+  }
+
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ReadThreadCpuTimes(std::map<int, uint64_t>* cpu_ns)
+{
+  cpu_ns->clear();
+  const std::string task_dir = "/proc/self/task";
+  DIR* dir = opendir(task_dir.c_str());
+  RETURN_ERROR_IF_TRUE(
+      dir == nullptr, TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("unable to list the threads of the process: ") +
+          strerror(errno));
+
+  // The first field of 'schedstat' is the time the thread has run for.
+  // A thread exiting meanwhile is left out.
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    int tid;
+    char trailing;
+    if (sscanf(entry->d_name, "%d%c", &tid, &trailing) != 1) {
+      continue;
+    }
+    std::ifstream file(
+        task_dir + "/" + entry->d_name + "/schedstat", std::ios::in);
+    unsigned long long run_ns;
+    if (file.is_open() && (file >> run_ns)) {
+      (*cpu_ns)[tid] = run_ns;
+    }
+  }
+  closedir(dir);
+
+  RETURN_ERROR_IF_TRUE(
+      cpu_ns->empty(), TRITONSERVER_ERROR_UNSUPPORTED,
+      std::string("the kernel doesn't report the CPU time of the threads"));
+
+  return nullptr;
+}
+
+ScopedThreadAffinity::ScopedThreadAffinity(const std::vector<int>& cpus)
+{
+  std::unique_ptr<SavedAffinity> saved(new SavedAffinity());
+  if (sched_getaffinity(0, sizeof(saved->cpus), &saved->cpus) == 0) {
+    TRITONSERVER_Error* err = SetThreadAffinity(cpus);
+    if (err == nullptr) {
+      saved_ = std::move(saved);
+    } else {
+      LOG_IF_ERROR(err, "failed to restrict the CPUs of the thread");
+    }
+  }
+}
+
+ScopedThreadAffinity::~ScopedThreadAffinity()
+{
+  if (saved_ != nullptr) {
+    sched_setaffinity(0, sizeof(saved_->cpus), &saved_->cpus);
+  }
+}
+#else
+struct ScopedThreadAffinity::SavedAffinity {
+};
+
+TRITONSERVER_Error*
+SetThreadAffinity(const std::vector<int>& cpus)
+{
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "setting the CPU affinity of a thread is only supported on Linux");
+}
+
+TRITONSERVER_Error*
+GetThreadAffinity(const int tid, std::vector<int>* cpus)
+{
+  cpus->clear();
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "getting the CPU affinity of a thread is only supported on Linux");
+}
+
+TRITONSERVER_Error*
+ReadThreadCpuTimes(std::map<int, uint64_t>* cpu_ns)
+{
+  cpu_ns->clear();
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED,
+      "reading the CPU time of the threads is only supported on Linux");
+}
+
+ScopedThreadAffinity::ScopedThreadAffinity(const std::vector<int>& cpus)
+{
+  LOG_IF_ERROR(
+      SetThreadAffinity(cpus), "failed to restrict the CPUs of the thread");
+}
+
+ScopedThreadAffinity::~ScopedThreadAffinity() {}
+#endif  // __linux__
+
+uint64_t
+HashBytes(const void* data, const size_t size, uint64_t hash)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+uint64_t
+HashString(const std::string& str, uint64_t hash)
+{
+  // Hash the terminating null as well so that consecutive strings hash
+  // differently than their concatenation.
+  return HashBytes(str.c_str(), str.size() + 1, hash);
+}
+
+TRITONSERVER_Error*
+HashFile(const std::string& path, uint64_t* hash)
+{
+  std::ifstream file(path, std::ios::binary);
+  RETURN_ERROR_IF_FALSE(
+      file.is_open(), TRITONSERVER_ERROR_UNAVAILABLE,
+      std::string("unable to open '") + path + "' for hashing");
+
+  std::vector<char> buffer(1 << 20);
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+    *hash = HashBytes(buffer.data(), file.gcount(), *hash);
+  }
+  RETURN_ERROR_IF_TRUE(
+      file.bad(), TRITONSERVER_ERROR_INTERNAL,
+      std::string("failed to read '") + path + "' for hashing");
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+MakeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+  const int status = _mkdir(path.c_str());
+#else
+  const int status = mkdir(path.c_str(), 0755);
+#endif
+  if ((status != 0) && (errno != EEXIST)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("unable to create the directory '") + path +
+         "': " + strerror(errno))
+            .c_str());
+  }
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+RenameFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+  // Unlike rename(), MoveFileEx replaces an existing file.
+  if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("unable to rename '") + from + "' to '" + to +
+         "': error " + std::to_string(GetLastError()))
+            .c_str());
+  }
+#else
+  if (rename(from.c_str(), to.c_str()) != 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::string("unable to rename '") + from + "' to '" + to +
+         "': " + strerror(errno))
+            .c_str());
+  }
+#endif
+
+  return nullptr;  // success
+}
+
 }}}  // namespace triton::backend::openvino
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <openvino/openvino.hpp>
 #include <set>
 #include <string>
@@ -90,9 +92,12 @@ ov::element::Type ModelConfigDataTypeToOpenVINOElement(
 std::string OpenVINOElementToModelConfigDataType(
     const ov::element::Type& data_type);
 
+// Checks that the shape of the tensor 'tensor_name' in the model matches
+// the 'dims' of the model configuration. The batch dimension is only
+// compared if 'compare_exact'.
 TRITONSERVER_Error* CompareDimsSupported(
     const std::string& model_name, const std::string& tensor_name,
-    const std::vector<size_t>& model_shape, const std::vector<int64_t>& dims,
+    const ov::PartialShape& model_shape, const std::vector<int64_t>& dims,
     const int max_batch_size, const bool compare_exact);
 
 TRITONSERVER_Error* ReadParameter(
@@ -100,5 +105,55 @@ TRITONSERVER_Error* ReadParameter(
     std::string* param);
 
 std::vector<int64_t> ConvertToSignedShape(const std::vector<size_t> shape);
+// Returns whether 'shape' is one of the shapes 'partial_shape' allows,
+// without building a PartialShape out of it.
+bool IsCompatibleShape(
+    const ov::PartialShape& partial_shape, const ov::Shape& shape);
+
+// Returns in 'node_cpus' the CPUs of each NUMA node of the host by node
+// id, empty if the host doesn't expose its NUMA topology. The NUMA
+// placement is only supported on Linux, elsewhere this and the functions
+// on the threads below return UNSUPPORTED.
+TRITONSERVER_Error* ReadNumaNodes(std::map<int, std::vector<int>>* node_cpus);
+// Parses a list of CPUs such as "0-3,8,10-11" into 'cpus'.
+TRITONSERVER_Error* ParseCpuList(
+    const std::string& cpu_list, std::vector<int>* cpus);
+// Restricts the calling thread to run on 'cpus'.
+TRITONSERVER_Error* SetThreadAffinity(const std::vector<int>& cpus);
+// Returns in 'cpus' the CPUs the thread 'tid' of the process may run on.
+TRITONSERVER_Error* GetThreadAffinity(const int tid, std::vector<int>* cpus);
+// Returns in 'cpu_ns' the CPU time, in ns, each thread of the process has
+// run for so far, by thread id.
+TRITONSERVER_Error* ReadThreadCpuTimes(std::map<int, uint64_t>* cpu_ns);
+
+// Restricts the calling thread to run on a set of CPUs for the lifetime
+// of the object, so that the threads it creates meanwhile inherit the
+// restriction, and restores its previous CPUs afterwards.
+class ScopedThreadAffinity {
+ public:
+  explicit ScopedThreadAffinity(const std::vector<int>& cpus);
+  ~ScopedThreadAffinity();
+
+ private:
+  // The CPUs of the thread before, null if they are not to be restored.
+  struct SavedAffinity;
+  std::unique_ptr<SavedAffinity> saved_;
+};
+
+// The 64-bit FNV-1a hash of 'size' bytes at 'data', continuing from the
+// hash 'hash' of the preceding bytes.
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+uint64_t HashBytes(
+    const void* data, const size_t size, uint64_t hash = kFnvOffsetBasis);
+uint64_t HashString(const std::string& str, uint64_t hash = kFnvOffsetBasis);
+// Hashes the content of the file at 'path' into 'hash', continuing from
+// its value.
+TRITONSERVER_Error* HashFile(const std::string& path, uint64_t* hash);
+
+// Creates the directory 'path' unless it exists already.
+TRITONSERVER_Error* MakeDirectory(const std::string& path);
+// Renames the file 'from' to 'to', replacing 'to' atomically if it
+// exists.
+TRITONSERVER_Error* RenameFile(const std::string& from, const std::string& to);
 
 }}}  // namespace triton::backend::openvino
@@ -0,0 +1,386 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "backend_harness.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "triton/backend/backend_common.h"
+
+namespace triton { namespace backend { namespace openvino { namespace mock {
+
+uint64_t
+Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool
+ArgValue(const char* arg, const char* key, std::string* value)
+{
+  const size_t key_len = strlen(key);
+  if ((strncmp(arg, key, key_len) != 0) || (arg[key_len] != '=')) {
+    return false;
+  }
+  *value = arg + key_len + 1;
+  return true;
+}
+
+TRITONSERVER_Error*
+ParseNumber(const char* option, const std::string& str, uint64_t* number)
+{
+  bool valid = !str.empty() &&
+               (str.find_first_not_of("0123456789") == std::string::npos);
+  if (valid) {
+    try {
+      *number = std::stoull(str);
+    }
+    catch (const std::out_of_range&) {
+      valid = false;
+    }
+  }
+  if (!valid) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("expected ") + option + " to be a number, got '" + str +
+         "'")
+            .c_str());
+  }
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ParseDims(const std::string& str, std::vector<int64_t>* dims)
+{
+  dims->clear();
+  std::stringstream ss(str);
+  std::string dim;
+  while (std::getline(ss, dim, ',')) {
+    bool valid = !dim.empty() &&
+                 (dim.find_first_not_of("0123456789") == std::string::npos);
+    if (valid) {
+      try {
+        dims->push_back(std::stoll(dim));
+      }
+      catch (const std::out_of_range&) {
+        valid = false;
+      }
+    }
+    if (!valid) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          ("expected a list of numbers, got '" + str + "'").c_str());
+    }
+  }
+  return nullptr;
+}
+
+void
+FillInput(
+    const TRITONSERVER_DataType datatype, const size_t count,
+    std::vector<char>* buffer)
+{
+  const size_t element_size = TRITONSERVER_DataTypeByteSize(datatype);
+  buffer->assign(count * element_size, 0);
+  for (size_t i = 0; i < count; i++) {
+    char* element = buffer->data() + i * element_size;
+    switch (datatype) {
+      case TRITONSERVER_TYPE_FP32: {
+        float value = (i % 97) / 97.0f;
+        memcpy(element, &value, sizeof(value));
+        break;
+      }
+      case TRITONSERVER_TYPE_FP64: {
+        double value = (i % 97) / 97.0;
+        memcpy(element, &value, sizeof(value));
+        break;
+      }
+      case TRITONSERVER_TYPE_FP16:
+        // Leave as 0.0.
+        break;
+      case TRITONSERVER_TYPE_BOOL:
+        element[0] = i % 2;
+        break;
+      default:
+        // The low byte, of a little-endian integer.
+        element[0] = i % 10;
+        break;
+    }
+  }
+}
+
+//
+// Recorder
+//
+void
+Recorder::ResponseSent(
+    Request* request, Response* response, bool final,
+    TRITONSERVER_Error* error)
+{
+  if (!final) {
+    return;
+  }
+  const uint64_t now_ns = Now();
+  std::lock_guard<std::mutex> lock(mu_);
+  request->response_ns = now_ns;
+  if (error != nullptr) {
+    failed_count_++;
+    if (first_error_.empty()) {
+      first_error_ = TRITONSERVER_ErrorMessage(error);
+    }
+  }
+}
+
+void
+Recorder::RequestReleased(Request* request)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  released_count_++;
+  cv_.notify_all();
+}
+
+void
+Recorder::BatchExecuted(
+    uint64_t batch_size, uint64_t exec_start_ns, uint64_t compute_start_ns,
+    uint64_t compute_end_ns, uint64_t exec_end_ns)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  if (measuring_) {
+    exec_ns_ += exec_end_ns - exec_start_ns;
+    compute_ns_ += compute_end_ns - compute_start_ns;
+  }
+}
+
+void
+Recorder::WaitForReleased(const size_t count)
+{
+  std::unique_lock<std::mutex> lock(mu_);
+  cv_.wait(lock, [this, count] { return released_count_ >= count; });
+}
+
+void
+Recorder::StartMeasuring()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  measuring_ = true;
+}
+
+size_t
+Recorder::FailedCount()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return failed_count_;
+}
+
+std::string
+Recorder::FirstError()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return first_error_;
+}
+
+uint64_t
+Recorder::ExecNs()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return exec_ns_;
+}
+
+uint64_t
+Recorder::ComputeNs()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return compute_ns_;
+}
+
+//
+// Harness
+//
+namespace {
+
+// Reads the model configuration and adds 'parameters' to it.
+TRITONSERVER_Error*
+ReadModelConfig(
+    const std::string& model_dir, const std::string& model,
+    const std::string& config_path,
+    const std::vector<std::pair<std::string, std::string>>& parameters,
+    std::string* config)
+{
+  const std::string path =
+      config_path.empty() ? (model_dir + "/config.json") : config_path;
+  std::ifstream file(path);
+  if (file) {
+    std::stringstream ss;
+    ss << file.rdbuf();
+    *config = ss.str();
+  } else if (!config_path.empty()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_NOT_FOUND,
+        ("failed to read the model configuration '" + path + "'").c_str());
+  } else {
+    *config = "{\"name\": \"" + model + "\", \"backend\": \"openvino\"}";
+  }
+
+  common::TritonJson::Value json;
+  RETURN_IF_ERROR(json.Parse(*config));
+  common::TritonJson::Value params;
+  if (!json.Find("parameters", &params)) {
+    common::TritonJson::Value new_params(
+        json, common::TritonJson::ValueType::OBJECT);
+    RETURN_IF_ERROR(json.Add("parameters", std::move(new_params)));
+    json.Find("parameters", &params);
+  }
+  for (const auto& param : parameters) {
+    common::TritonJson::Value existing;
+    if (params.Find(param.first.c_str(), &existing)) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          ("the parameter '" + param.first +
+           "' is already set in the model configuration")
+              .c_str());
+    }
+    common::TritonJson::Value value(
+        json, common::TritonJson::ValueType::OBJECT);
+    RETURN_IF_ERROR(value.AddString("string_value", param.second));
+    RETURN_IF_ERROR(params.Add(param.first.c_str(), std::move(value)));
+  }
+
+  common::TritonJson::WriteBuffer buffer;
+  RETURN_IF_ERROR(json.Write(&buffer));
+  *config = buffer.Contents();
+  return nullptr;
+}
+
+}  // namespace
+
+TRITONSERVER_Error*
+Harness::Load(
+    const std::string& repository, const std::string& model,
+    const uint64_t version, const std::string& config_path,
+    const std::vector<std::pair<std::string, std::string>>& parameters,
+    Observer* observer)
+{
+  backend_.name = "openvino";
+  backend_.config.json = "{\"cmdline\":{}}";
+  model_.backend = &backend_;
+  model_.name = model;
+  model_.version = version;
+  model_.path = repository + "/" + model;
+  model_.auto_complete_config = true;
+  RETURN_IF_ERROR(ReadModelConfig(
+      model_.path, model, config_path, parameters, &model_.config));
+  instance_.model = &model_;
+  instance_.name = model + "_0";
+  instance_.host_policy.json = "{\"" + instance_.name + "\":{}}";
+  instance_.observer = observer;
+
+  RETURN_IF_ERROR(
+      TRITONBACKEND_Initialize(Handle<TRITONBACKEND_Backend>(&backend_)));
+  RETURN_IF_ERROR(
+      TRITONBACKEND_ModelInitialize(Handle<TRITONBACKEND_Model>(&model_)));
+  RETURN_IF_ERROR(TRITONBACKEND_ModelInstanceInitialize(
+      Handle<TRITONBACKEND_ModelInstance>(&instance_)));
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+Harness::ModelConfig(
+    const std::map<std::string, std::vector<int64_t>>& shapes,
+    std::vector<ModelInput>* inputs, std::vector<std::string>* outputs,
+    int64_t* max_batch_size)
+{
+  common::TritonJson::Value json;
+  RETURN_IF_ERROR(json.Parse(model_.config));
+  *max_batch_size = 0;
+  if (json.Find("max_batch_size")) {
+    RETURN_IF_ERROR(json.MemberAsInt("max_batch_size", max_batch_size));
+  }
+
+  common::TritonJson::Value ios;
+  RETURN_IF_ERROR(json.MemberAsArray("input", &ios));
+  for (size_t i = 0; i < ios.ArraySize(); i++) {
+    common::TritonJson::Value io;
+    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
+    ModelInput input;
+    RETURN_IF_ERROR(io.MemberAsString("name", &input.name));
+    std::string data_type;
+    RETURN_IF_ERROR(io.MemberAsString("data_type", &data_type));
+    input.datatype = ModelConfigDataTypeToTritonServerDataType(data_type);
+    if (TRITONSERVER_DataTypeByteSize(input.datatype) == 0) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          ("the data type " + data_type + " of the input '" + input.name +
+           "' is not supported")
+              .c_str());
+    }
+    RETURN_IF_ERROR(ParseShape(io, "dims", &input.dims));
+    auto it = shapes.find(input.name);
+    if (it != shapes.end()) {
+      input.dims = it->second;
+    }
+    inputs->push_back(input);
+  }
+
+  RETURN_IF_ERROR(json.MemberAsArray("output", &ios));
+  for (size_t i = 0; i < ios.ArraySize(); i++) {
+    common::TritonJson::Value io;
+    RETURN_IF_ERROR(ios.IndexAsObject(i, &io));
+    std::string name;
+    RETURN_IF_ERROR(io.MemberAsString("name", &name));
+    outputs->push_back(name);
+  }
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+Harness::Execute(std::vector<TRITONBACKEND_Request*>* requests)
+{
+  return TRITONBACKEND_ModelInstanceExecute(
+      Handle<TRITONBACKEND_ModelInstance>(&instance_), requests->data(),
+      requests->size());
+}
+
+TRITONSERVER_Error*
+Harness::Unload()
+{
+  RETURN_IF_ERROR(TRITONBACKEND_ModelInstanceFinalize(
+      Handle<TRITONBACKEND_ModelInstance>(&instance_)));
+  RETURN_IF_ERROR(
+      TRITONBACKEND_ModelFinalize(Handle<TRITONBACKEND_Model>(&model_)));
+  RETURN_IF_ERROR(
+      TRITONBACKEND_Finalize(Handle<TRITONBACKEND_Backend>(&backend_)));
+  return nullptr;
+}
+
+}}}}  // namespace triton::backend::openvino::mock
@@ -0,0 +1,130 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "triton_api_mock.h"
+
+// The backend loaded with a model through the mock of the Triton API,
+// shared by the tools that drive the backend without a Triton server.
+
+namespace triton { namespace backend { namespace openvino { namespace mock {
+
+// The time in ns, on the clock of the timestamps of the backend.
+uint64_t Now();
+
+// Returns whether 'arg' is '<key>=<value>', and the value if so.
+bool ArgValue(const char* arg, const char* key, std::string* value);
+// Parses the value 'str' of 'option' as a non-negative number.
+TRITONSERVER_Error* ParseNumber(
+    const char* option, const std::string& str, uint64_t* number);
+// Parses a comma-separated list of numbers.
+TRITONSERVER_Error* ParseDims(
+    const std::string& str, std::vector<int64_t>* dims);
+
+// Fills 'buffer' with 'count' elements of 'datatype', small values that
+// don't hit the slow paths of the denormal or special numbers.
+void FillInput(
+    const TRITONSERVER_DataType datatype, const size_t count,
+    std::vector<char>* buffer);
+
+// An input of the model, as configured.
+struct ModelInput {
+  std::string name;
+  TRITONSERVER_DataType datatype;
+  std::vector<int64_t> dims;
+};
+
+// Records the completion of the requests, in their 'response_ns', and
+// the time spent in the executions once measuring.
+class Recorder : public Observer {
+ public:
+  void ResponseSent(
+      Request* request, Response* response, bool final,
+      TRITONSERVER_Error* error) override;
+  void RequestReleased(Request* request) override;
+  void BatchExecuted(
+      uint64_t batch_size, uint64_t exec_start_ns, uint64_t compute_start_ns,
+      uint64_t compute_end_ns, uint64_t exec_end_ns) override;
+
+  // Waits for 'count' requests in all to be released.
+  void WaitForReleased(const size_t count);
+  void StartMeasuring();
+
+  size_t FailedCount();
+  std::string FirstError();
+  // The time spent in the measured executions, and in their inferences.
+  uint64_t ExecNs();
+  uint64_t ComputeNs();
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  size_t released_count_ = 0;
+  size_t failed_count_ = 0;
+  std::string first_error_;
+  bool measuring_ = false;
+  uint64_t exec_ns_ = 0;
+  uint64_t compute_ns_ = 0;
+};
+
+// The backend with a model and an instance of it loaded.
+class Harness {
+ public:
+  // Loads 'model' of 'repository'. Its configuration is read, as JSON,
+  // from 'config_path' or else 'config.json' in the model directory and
+  // is otherwise completed by the backend. 'parameters' are added to it.
+  TRITONSERVER_Error* Load(
+      const std::string& repository, const std::string& model,
+      const uint64_t version, const std::string& config_path,
+      const std::vector<std::pair<std::string, std::string>>& parameters,
+      Observer* observer);
+
+  // Reads the inputs, with the dims of 'shapes' in place of the
+  // configured ones, the outputs and the max batch size of the model.
+  TRITONSERVER_Error* ModelConfig(
+      const std::map<std::string, std::vector<int64_t>>& shapes,
+      std::vector<ModelInput>* inputs, std::vector<std::string>* outputs,
+      int64_t* max_batch_size);
+
+  TRITONSERVER_Error* Execute(std::vector<TRITONBACKEND_Request*>* requests);
+
+  TRITONSERVER_Error* Unload();
+
+ private:
+  Backend backend_;
+  Model model_;
+  Instance instance_;
+};
+
+}}}}  // namespace triton::backend::openvino::mock
@@ -0,0 +1,346 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Checks that the executions of the backend don't allocate once warmed
+// up. The allocation functions of the C library are replaced by ones
+// counting the allocations made while armed, apart from those the mock
+// makes on behalf of the server, and the test fails if any is counted
+// in the executions after the warm-up. Requires glibc.
+//
+// openvino_allocation_test --model-repository=<dir> --model=<name>
+//     [--version=1] [--config=<json>] [--param=<key>=<value>]...
+//     [--batch=<rows>,<rows>,...]... [--shape=<input>:<dim>,<dim>,...]...
+//     [--executions=100] [--warmup=10]
+//
+// The options are those of openvino_backend_benchmark. The requests of
+// each '--batch' are created once and sent again by the executions
+// cycling through them, each waiting for the previous one to release its
+// requests. The warm-up runs every '--batch' at least once.
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backend_harness.h"
+#include "triton/backend/backend_common.h"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+namespace triton { namespace backend { namespace openvino { namespace mock {
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocation_count{0};
+std::atomic<uint64_t> allocation_bytes{0};
+
+void
+CountAllocation(const size_t size)
+{
+  // 'counting' first, the mock isn't set up before main().
+  if (counting.load(std::memory_order_relaxed) && !ServerScope::Active()) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+}
+
+struct Options {
+  std::string repository;
+  std::string model;
+  uint64_t version = 1;
+  std::string config_path;
+  std::vector<std::pair<std::string, std::string>> parameters;
+  std::vector<std::vector<int64_t>> batches;
+  std::map<std::string, std::vector<int64_t>> shapes;
+  uint64_t executions = 100;
+  uint64_t warmup = 10;
+};
+
+TRITONSERVER_Error*
+ParseOptions(int argc, char** argv, Options* options)
+{
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    std::string value;
+    if (ArgValue(arg, "--model-repository", &value)) {
+      options->repository = value;
+    } else if (ArgValue(arg, "--model", &value)) {
+      options->model = value;
+    } else if (ArgValue(arg, "--version", &value)) {
+      RETURN_IF_ERROR(ParseNumber("--version", value, &options->version));
+    } else if (ArgValue(arg, "--config", &value)) {
+      options->config_path = value;
+    } else if (ArgValue(arg, "--param", &value)) {
+      const size_t pos = value.find('=');
+      if (pos == std::string::npos) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            ("expected --param=<key>=<value>, got '" + value + "'").c_str());
+      }
+      options->parameters.emplace_back(
+          value.substr(0, pos), value.substr(pos + 1));
+    } else if (ArgValue(arg, "--batch", &value)) {
+      std::vector<int64_t> batch;
+      RETURN_IF_ERROR(ParseDims(value, &batch));
+      if (batch.empty()) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            "expected --batch to list at least one request");
+      }
+      options->batches.push_back(batch);
+    } else if (ArgValue(arg, "--shape", &value)) {
+      const size_t pos = value.find(':');
+      if (pos == std::string::npos) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            ("expected --shape=<input>:<dims>, got '" + value + "'").c_str());
+      }
+      RETURN_IF_ERROR(ParseDims(
+          value.substr(pos + 1), &options->shapes[value.substr(0, pos)]));
+    } else if (ArgValue(arg, "--executions", &value)) {
+      RETURN_IF_ERROR(
+          ParseNumber("--executions", value, &options->executions));
+    } else if (ArgValue(arg, "--warmup", &value)) {
+      RETURN_IF_ERROR(ParseNumber("--warmup", value, &options->warmup));
+    } else {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("unexpected argument '") + arg + "'").c_str());
+    }
+  }
+  if (options->repository.empty() || options->model.empty()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "--model-repository and --model are required");
+  }
+  if (options->executions == 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG, "--executions must be at least 1");
+  }
+  if (options->batches.empty()) {
+    options->batches.push_back({1});
+  }
+  options->warmup = std::max<uint64_t>(
+      options->warmup, options->batches.size());
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+Run(const Options& options)
+{
+  Recorder recorder;
+  Harness harness;
+  RETURN_IF_ERROR(harness.Load(
+      options.repository, options.model, options.version,
+      options.config_path, options.parameters, &recorder));
+
+  std::vector<ModelInput> inputs;
+  std::vector<std::string> outputs;
+  int64_t max_batch_size;
+  RETURN_IF_ERROR(
+      harness.ModelConfig(options.shapes, &inputs, &outputs, &max_batch_size));
+  for (const auto& input : inputs) {
+    if (std::find(input.dims.begin(), input.dims.end(), -1) !=
+        input.dims.end()) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          ("the input '" + input.name +
+           "' has variable dims, set them with --shape")
+              .c_str());
+    }
+  }
+
+  // The requests of each batch, created up front so that the executions
+  // only send them again.
+  std::map<std::pair<size_t, int64_t>, std::vector<char>> input_data;
+  std::vector<std::unique_ptr<Request>> requests;
+  std::vector<std::vector<TRITONBACKEND_Request*>> batch_requests;
+  for (const auto& batch : options.batches) {
+    batch_requests.emplace_back();
+    for (const auto rows : batch) {
+      std::unique_ptr<Request> request(new Request());
+      request->observer = &recorder;
+      request->id = std::to_string(requests.size());
+      request->batch_size = rows;
+      request->requested_outputs = outputs;
+      for (size_t i = 0; i < inputs.size(); i++) {
+        Input input;
+        input.name = inputs[i].name;
+        input.datatype = inputs[i].datatype;
+        if (max_batch_size > 0) {
+          input.shape.push_back(rows);
+        }
+        input.shape.insert(
+            input.shape.end(), inputs[i].dims.begin(), inputs[i].dims.end());
+        auto& data = input_data[{i, rows}];
+        if (data.empty()) {
+          FillInput(input.datatype, GetElementCount(input.shape), &data);
+        }
+        input.buffer = data.data();
+        input.byte_size = data.size();
+        request->inputs.push_back(input);
+      }
+      batch_requests.back().push_back(
+          Handle<TRITONBACKEND_Request>(request.get()));
+      requests.push_back(std::move(request));
+    }
+  }
+
+  // The requests are sent again once released, so the executions run
+  // one at a time. The copies of the request lists passed to the
+  // backend are made before arming too.
+  std::vector<std::vector<TRITONBACKEND_Request*>> exec_requests(
+      batch_requests);
+  const size_t execution_count = options.warmup + options.executions;
+  size_t released_count = 0;
+  TRITONSERVER_Error* err = nullptr;
+  for (size_t exec = 0; (exec < execution_count) && (err == nullptr);
+       exec++) {
+    if (exec == options.warmup) {
+      counting = true;
+    }
+    const size_t idx = exec % batch_requests.size();
+    exec_requests[idx] = batch_requests[idx];
+    err = harness.Execute(&exec_requests[idx]);
+    if (err == nullptr) {
+      released_count += batch_requests[idx].size();
+      recorder.WaitForReleased(released_count);
+    }
+  }
+  counting = false;
+  RETURN_IF_ERROR(err);
+  RETURN_IF_ERROR(harness.Unload());
+
+  if (recorder.FailedCount() > 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::to_string(recorder.FailedCount()) +
+         " requests failed, first error: " + recorder.FirstError())
+            .c_str());
+  }
+  if (allocation_count > 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INTERNAL,
+        (std::to_string(allocation_count.load()) + " allocations of " +
+         std::to_string(allocation_bytes.load()) + " bytes in " +
+         std::to_string(options.executions) +
+         " executions after the warm-up")
+            .c_str());
+  }
+  printf(
+      "no allocations in %lu executions after the warm-up\n",
+      (unsigned long)options.executions);
+  return nullptr;
+}
+
+}  // namespace
+
+}}}}  // namespace triton::backend::openvino::mock
+
+extern "C" {
+
+void*
+malloc(size_t size)
+{
+  triton::backend::openvino::mock::CountAllocation(size);
+  return __libc_malloc(size);
+}
+
+void*
+calloc(size_t count, size_t size)
+{
+  triton::backend::openvino::mock::CountAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+  triton::backend::openvino::mock::CountAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+void*
+memalign(size_t alignment, size_t size)
+{
+  triton::backend::openvino::mock::CountAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void*
+aligned_alloc(size_t alignment, size_t size)
+{
+  triton::backend::openvino::mock::CountAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+int
+posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+  if ((alignment % sizeof(void*) != 0) ||
+      ((alignment & (alignment - 1)) != 0)) {
+    return EINVAL;
+  }
+  triton::backend::openvino::mock::CountAllocation(size);
+  void* allocated = __libc_memalign(alignment, size);
+  if (allocated == nullptr) {
+    return ENOMEM;
+  }
+  *ptr = allocated;
+  return 0;
+}
+
+}  // extern "C"
+
+int
+main(int argc, char** argv)
+{
+  using namespace triton::backend::openvino::mock;
+
+  Options options;
+  TRITONSERVER_Error* err = ParseOptions(argc, argv, &options);
+  if (err == nullptr) {
+    err = Run(options);
+  }
+  if (err != nullptr) {
+    fprintf(stderr, "error: %s\n", TRITONSERVER_ErrorMessage(err));
+    TRITONSERVER_ErrorDelete(err);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,306 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Drives the backend through the TRITONBACKEND API, implemented by the
+// mock in place of a Triton server, with synthetic requests, to measure
+// the overhead of the backend apart from the server.
+//
+// openvino_backend_benchmark --model-repository=<dir> --model=<name>
+//     [--version=1] [--config=<json>] [--param=<key>=<value>]...
+//     [--batch=<rows>,<rows>,...]... [--shape=<input>:<dim>,<dim>,...]...
+//     [--output=<name>]... [--executions=1000] [--warmup=10] [-v|-vv]
+//
+// Each '--batch' is the number of rows of each request of an execution,
+// the executions cycle through them, "1" by default. '--shape' gives the
+// dims of an input, without the batch dim, in place of those of the
+// model configuration, required for the variable dims. The model
+// configuration is read, as JSON, from '--config' or else 'config.json'
+// in the model directory, and is otherwise completed by the backend.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backend_harness.h"
+#include "triton/backend/backend_common.h"
+
+namespace triton { namespace backend { namespace openvino { namespace mock {
+
+namespace {
+
+struct Options {
+  std::string repository;
+  std::string model;
+  uint64_t version = 1;
+  std::string config_path;
+  std::vector<std::pair<std::string, std::string>> parameters;
+  std::vector<std::vector<int64_t>> batches;
+  std::map<std::string, std::vector<int64_t>> shapes;
+  std::vector<std::string> outputs;
+  uint64_t executions = 1000;
+  uint64_t warmup = 10;
+  TRITONSERVER_LogLevel log_level = TRITONSERVER_LOG_WARN;
+};
+
+TRITONSERVER_Error*
+ParseOptions(int argc, char** argv, Options* options)
+{
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    std::string value;
+    if (ArgValue(arg, "--model-repository", &value)) {
+      options->repository = value;
+    } else if (ArgValue(arg, "--model", &value)) {
+      options->model = value;
+    } else if (ArgValue(arg, "--version", &value)) {
+      RETURN_IF_ERROR(ParseNumber("--version", value, &options->version));
+    } else if (ArgValue(arg, "--config", &value)) {
+      options->config_path = value;
+    } else if (ArgValue(arg, "--param", &value)) {
+      const size_t pos = value.find('=');
+      if (pos == std::string::npos) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            ("expected --param=<key>=<value>, got '" + value + "'").c_str());
+      }
+      options->parameters.emplace_back(
+          value.substr(0, pos), value.substr(pos + 1));
+    } else if (ArgValue(arg, "--batch", &value)) {
+      std::vector<int64_t> batch;
+      RETURN_IF_ERROR(ParseDims(value, &batch));
+      if (batch.empty()) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            "expected --batch to list at least one request");
+      }
+      options->batches.push_back(batch);
+    } else if (ArgValue(arg, "--shape", &value)) {
+      const size_t pos = value.find(':');
+      if (pos == std::string::npos) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            ("expected --shape=<input>:<dims>, got '" + value + "'").c_str());
+      }
+      RETURN_IF_ERROR(ParseDims(
+          value.substr(pos + 1), &options->shapes[value.substr(0, pos)]));
+    } else if (ArgValue(arg, "--output", &value)) {
+      options->outputs.push_back(value);
+    } else if (ArgValue(arg, "--executions", &value)) {
+      RETURN_IF_ERROR(
+          ParseNumber("--executions", value, &options->executions));
+    } else if (ArgValue(arg, "--warmup", &value)) {
+      RETURN_IF_ERROR(ParseNumber("--warmup", value, &options->warmup));
+    } else if (strcmp(arg, "-v") == 0) {
+      options->log_level = TRITONSERVER_LOG_INFO;
+    } else if (strcmp(arg, "-vv") == 0) {
+      options->log_level = TRITONSERVER_LOG_VERBOSE;
+    } else {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("unexpected argument '") + arg + "'").c_str());
+    }
+  }
+  if (options->repository.empty() || options->model.empty()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "--model-repository and --model are required");
+  }
+  if (options->executions == 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG, "--executions must be at least 1");
+  }
+  if (options->batches.empty()) {
+    options->batches.push_back({1});
+  }
+  return nullptr;
+}
+
+// The latency below which 'percent' of the sorted 'latencies_ns' are.
+uint64_t
+Percentile(const std::vector<uint64_t>& latencies_ns, const size_t percent)
+{
+  size_t idx = (latencies_ns.size() * percent + 99) / 100;
+  return latencies_ns[std::max<size_t>(idx, 1) - 1];
+}
+
+void
+Report(
+    const Options& options, Recorder& recorder,
+    const std::vector<std::unique_ptr<Request>>& requests,
+    const uint64_t duration_ns)
+{
+  std::vector<uint64_t> latencies_ns;
+  uint64_t rows = 0;
+  uint64_t total_ns = 0;
+  for (const auto& request : requests) {
+    if (request->measured) {
+      latencies_ns.push_back(request->response_ns - request->arrival_ns);
+      total_ns += latencies_ns.back();
+      rows += request->batch_size;
+    }
+  }
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+
+  const double duration_sec = duration_ns / 1e9;
+  printf("executions: %zu\n", options.executions);
+  printf("requests: %zu\n", latencies_ns.size());
+  printf("rows: %lu\n", (unsigned long)rows);
+  printf("failed requests: %zu\n", recorder.FailedCount());
+  if (recorder.FailedCount() > 0) {
+    printf("first error: %s\n", recorder.FirstError().c_str());
+  }
+  printf("duration: %.3f s\n", duration_sec);
+  printf(
+      "throughput: %.1f infer/s, %.1f requests/s, %.1f executions/s\n",
+      rows / duration_sec, latencies_ns.size() / duration_sec,
+      options.executions / duration_sec);
+  printf(
+      "latency (us): mean %.1f, p50 %.1f, p90 %.1f, p95 %.1f, p99 %.1f, "
+      "max %.1f\n",
+      total_ns / 1e3 / latencies_ns.size(),
+      Percentile(latencies_ns, 50) / 1e3, Percentile(latencies_ns, 90) / 1e3,
+      Percentile(latencies_ns, 95) / 1e3, Percentile(latencies_ns, 99) / 1e3,
+      latencies_ns.back() / 1e3);
+  const uint64_t exec_ns = recorder.ExecNs();
+  if (exec_ns > 0) {
+    printf(
+        "outside infer(): %.1f%% of the execution time\n",
+        100.0 * (exec_ns - std::min(recorder.ComputeNs(), exec_ns)) /
+            exec_ns);
+  }
+}
+
+TRITONSERVER_Error*
+Run(const Options& options)
+{
+  SetLogLevel(options.log_level);
+  Recorder recorder;
+  Harness harness;
+  RETURN_IF_ERROR(harness.Load(
+      options.repository, options.model, options.version,
+      options.config_path, options.parameters, &recorder));
+
+  std::vector<ModelInput> inputs;
+  std::vector<std::string> outputs;
+  int64_t max_batch_size;
+  RETURN_IF_ERROR(
+      harness.ModelConfig(options.shapes, &inputs, &outputs, &max_batch_size));
+  if (!options.outputs.empty()) {
+    outputs = options.outputs;
+  }
+  for (const auto& input : inputs) {
+    if (std::find(input.dims.begin(), input.dims.end(), -1) !=
+        input.dims.end()) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          ("the input '" + input.name +
+           "' has variable dims, set them with --shape")
+              .c_str());
+    }
+  }
+
+  // The data of each input by number of rows, shared by the requests.
+  std::map<std::pair<size_t, int64_t>, std::vector<char>> input_data;
+  std::vector<std::unique_ptr<Request>> requests;
+  const size_t execution_count = options.warmup + options.executions;
+  uint64_t start_ns = 0;
+  for (size_t exec = 0; exec < execution_count; exec++) {
+    if (exec == options.warmup) {
+      recorder.WaitForReleased(requests.size());
+      recorder.StartMeasuring();
+      start_ns = Now();
+    }
+
+    const auto& batch = options.batches[exec % options.batches.size()];
+    std::vector<TRITONBACKEND_Request*> exec_requests;
+    for (const auto rows : batch) {
+      std::unique_ptr<Request> request(new Request());
+      request->observer = &recorder;
+      request->id = std::to_string(requests.size());
+      request->batch_size = rows;
+      request->measured = (exec >= options.warmup);
+      request->requested_outputs = outputs;
+      for (size_t i = 0; i < inputs.size(); i++) {
+        Input input;
+        input.name = inputs[i].name;
+        input.datatype = inputs[i].datatype;
+        if (max_batch_size > 0) {
+          input.shape.push_back(rows);
+        }
+        input.shape.insert(
+            input.shape.end(), inputs[i].dims.begin(), inputs[i].dims.end());
+        auto& data = input_data[{i, rows}];
+        if (data.empty()) {
+          FillInput(input.datatype, GetElementCount(input.shape), &data);
+        }
+        input.buffer = data.data();
+        input.byte_size = data.size();
+        request->inputs.push_back(input);
+      }
+      exec_requests.push_back(Handle<TRITONBACKEND_Request>(request.get()));
+      requests.push_back(std::move(request));
+    }
+
+    const uint64_t arrival_ns = Now();
+    for (auto exec_request : exec_requests) {
+      Object<Request>(exec_request)->arrival_ns = arrival_ns;
+    }
+    RETURN_IF_ERROR(harness.Execute(&exec_requests));
+  }
+  recorder.WaitForReleased(requests.size());
+  const uint64_t end_ns = Now();
+
+  RETURN_IF_ERROR(harness.Unload());
+  Report(options, recorder, requests, end_ns - start_ns);
+  return nullptr;
+}
+
+}  // namespace
+
+}}}}  // namespace triton::backend::openvino::mock
+
+int
+main(int argc, char** argv)
+{
+  using namespace triton::backend::openvino::mock;
+
+  Options options;
+  TRITONSERVER_Error* err = ParseOptions(argc, argv, &options);
+  if (err == nullptr) {
+    err = Run(options);
+  }
+  if (err != nullptr) {
+    fprintf(stderr, "error: %s\n", TRITONSERVER_ErrorMessage(err));
+    TRITONSERVER_ErrorDelete(err);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,480 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Generates synthetic OpenVINO IR models, along with the model
+// repository and configuration to serve them, so that benchmarks can run
+// on reproducible models without downloading any.
+//
+// openvino_model_generator --model-repository=<dir> --model=<name>
+//     --type=mlp|conv|transformer [--version=1] [--max-batch-size=8]
+//     [--static-batch] [--dynamic-dims] [--layers=4] [--seed=0]
+//     [--input-width=256] [--width=256] [--output-width=256]
+//     [--channels=16] [--height=56] [--image-width=56]
+//     [--sequence=128] [--hidden=256] [--heads=4]
+//
+// The models have an FP32 'INPUT' and 'OUTPUT':
+//   mlp: [batch, input-width], 'layers' dense layers with ReLU.
+//   conv: [batch, channels, height, image-width], 'layers' 3x3
+//     convolutions with ReLU.
+//   transformer: [batch, sequence, hidden], 'layers' encoder blocks of
+//     self-attention with 'heads' heads and a feed-forward of 4 x
+//     'hidden' with GELU, each normalized and residual.
+// With a 'max-batch-size' above 0 the batch dim is dynamic, unless
+// '--static-batch' fixes it to 'max-batch-size', and left out of the
+// configuration. Otherwise it is 1. '--dynamic-dims' makes the sequence,
+// or the height and width, dynamic. The weights are random, from 'seed'.
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <openvino/openvino.hpp>
+#include <openvino/opsets/opset8.hpp>
+#include <openvino/pass/serialize.hpp>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace ov::opset8;
+
+struct Options {
+  std::string repository;
+  std::string model;
+  std::string type;
+  uint64_t version = 1;
+  int64_t max_batch_size = 8;
+  bool static_batch = false;
+  bool dynamic_dims = false;
+  size_t layers = 4;
+  unsigned seed = 0;
+  // mlp
+  size_t input_width = 256;
+  size_t width = 256;
+  size_t output_width = 256;
+  // conv
+  size_t channels = 16;
+  size_t height = 56;
+  size_t image_width = 56;
+  // transformer
+  size_t sequence = 128;
+  size_t hidden = 256;
+  size_t heads = 4;
+};
+
+// Creates the constants of the model, the weights random and reproducible
+// from the seed.
+class Constants {
+ public:
+  explicit Constants(unsigned seed) : rng_(seed) {}
+
+  // Weights of 'shape' scaled for 'fan_in' inputs.
+  std::shared_ptr<ov::Node> Weights(const ov::Shape& shape, size_t fan_in)
+  {
+    const float scale = 1.0f / std::sqrt((float)fan_in);
+    std::uniform_real_distribution<float> dist(-scale, scale);
+    std::vector<float> values(ov::shape_size(shape));
+    for (auto& value : values) {
+      value = dist(rng_);
+    }
+    return Constant::create(ov::element::f32, shape, values);
+  }
+
+  std::shared_ptr<ov::Node> Fill(const ov::Shape& shape, float value)
+  {
+    return Constant::create(
+        ov::element::f32, shape,
+        std::vector<float>(ov::shape_size(shape), value));
+  }
+
+  std::shared_ptr<ov::Node> Ints(const std::vector<int64_t>& values)
+  {
+    return Constant::create(ov::element::i64, {values.size()}, values);
+  }
+
+ private:
+  std::mt19937 rng_;
+};
+
+// 'input' times weights of [in, out], plus a bias.
+ov::Output<ov::Node>
+Dense(
+    Constants& constants, const ov::Output<ov::Node>& input, size_t in,
+    size_t out)
+{
+  auto matmul =
+      std::make_shared<MatMul>(input, constants.Weights({in, out}, in));
+  return std::make_shared<Add>(matmul, constants.Fill({out}, 0.0f));
+}
+
+// Normalizes 'input' over its last dim.
+ov::Output<ov::Node>
+LayerNorm(Constants& constants, const ov::Output<ov::Node>& input, size_t dim)
+{
+  auto mvn = std::make_shared<MVN>(
+      input, constants.Ints({-1}), true, 1e-5f,
+      ov::op::MVNEpsMode::INSIDE_SQRT);
+  auto scaled = std::make_shared<Multiply>(mvn, constants.Fill({dim}, 1.0f));
+  return std::make_shared<Add>(scaled, constants.Fill({dim}, 0.0f));
+}
+
+ov::Output<ov::Node>
+Mlp(const Options& options, Constants& constants,
+    const ov::Output<ov::Node>& input)
+{
+  ov::Output<ov::Node> x = input;
+  size_t in = options.input_width;
+  for (size_t layer = 0; layer < options.layers; layer++) {
+    const size_t out = (layer + 1 == options.layers) ? options.output_width
+                                                      : options.width;
+    x = Dense(constants, x, in, out);
+    if (layer + 1 < options.layers) {
+      x = std::make_shared<Relu>(x);
+    }
+    in = out;
+  }
+  return x;
+}
+
+ov::Output<ov::Node>
+Conv(
+    const Options& options, Constants& constants,
+    const ov::Output<ov::Node>& input)
+{
+  ov::Output<ov::Node> x = input;
+  const size_t c = options.channels;
+  for (size_t layer = 0; layer < options.layers; layer++) {
+    auto conv = std::make_shared<Convolution>(
+        x, constants.Weights({c, c, 3, 3}, c * 9), ov::Strides{1, 1},
+        ov::CoordinateDiff{1, 1}, ov::CoordinateDiff{1, 1},
+        ov::Strides{1, 1});
+    auto bias =
+        std::make_shared<Add>(conv, constants.Fill({1, c, 1, 1}, 0.0f));
+    x = std::make_shared<Relu>(bias);
+  }
+  return x;
+}
+
+ov::Output<ov::Node>
+Transformer(
+    const Options& options, Constants& constants,
+    const ov::Output<ov::Node>& input)
+{
+  const size_t hidden = options.hidden;
+  const size_t heads = options.heads;
+  const int64_t head_dim = hidden / heads;
+  // [batch, sequence, hidden] <-> [batch, sequence, heads, head_dim]
+  auto split_heads = constants.Ints({0, 0, (int64_t)heads, head_dim});
+  auto merge_heads = constants.Ints({0, 0, (int64_t)hidden});
+
+  ov::Output<ov::Node> x = input;
+  for (size_t layer = 0; layer < options.layers; layer++) {
+    // Self-attention.
+    auto norm = LayerNorm(constants, x, hidden);
+    auto q = std::make_shared<Transpose>(
+        std::make_shared<Reshape>(
+            Dense(constants, norm, hidden, hidden), split_heads, true),
+        constants.Ints({0, 2, 1, 3}));
+    auto k = std::make_shared<Transpose>(
+        std::make_shared<Reshape>(
+            Dense(constants, norm, hidden, hidden), split_heads, true),
+        constants.Ints({0, 2, 3, 1}));
+    auto v = std::make_shared<Transpose>(
+        std::make_shared<Reshape>(
+            Dense(constants, norm, hidden, hidden), split_heads, true),
+        constants.Ints({0, 2, 1, 3}));
+    auto scores = std::make_shared<Multiply>(
+        std::make_shared<MatMul>(q, k),
+        constants.Fill({}, 1.0f / std::sqrt((float)head_dim)));
+    auto attention = std::make_shared<MatMul>(
+        std::make_shared<Softmax>(scores, -1), v);
+    auto merged = std::make_shared<Reshape>(
+        std::make_shared<Transpose>(attention, constants.Ints({0, 2, 1, 3})),
+        merge_heads, true);
+    x = std::make_shared<Add>(x, Dense(constants, merged, hidden, hidden));
+
+    // Feed-forward.
+    norm = LayerNorm(constants, x, hidden);
+    auto expanded = std::make_shared<Gelu>(
+        Dense(constants, norm, hidden, 4 * hidden),
+        ov::op::GeluApproximationMode::TANH);
+    x = std::make_shared<Add>(
+        x, Dense(constants, expanded, 4 * hidden, hidden));
+  }
+  return x;
+}
+
+std::shared_ptr<ov::Model>
+CreateModel(const Options& options)
+{
+  ov::Dimension batch(1);
+  if (options.max_batch_size > 0) {
+    batch = options.static_batch ? ov::Dimension(options.max_batch_size)
+                                 : ov::Dimension::dynamic();
+  }
+  auto dim = [&options](size_t value) {
+    return options.dynamic_dims ? ov::Dimension::dynamic()
+                                : ov::Dimension(value);
+  };
+
+  ov::PartialShape shape;
+  if (options.type == "mlp") {
+    shape = {batch, ov::Dimension(options.input_width)};
+  } else if (options.type == "conv") {
+    shape = {batch, ov::Dimension(options.channels), dim(options.height),
+             dim(options.image_width)};
+  } else if (options.type == "transformer") {
+    if ((options.heads == 0) || ((options.hidden % options.heads) != 0)) {
+      throw std::invalid_argument("--hidden must be a multiple of --heads");
+    }
+    shape = {batch, dim(options.sequence), ov::Dimension(options.hidden)};
+  } else {
+    throw std::invalid_argument(
+        "expected --type to be mlp, conv or transformer, got '" +
+        options.type + "'");
+  }
+
+  auto input = std::make_shared<Parameter>(ov::element::f32, shape);
+  input->set_friendly_name("INPUT");
+  input->output(0).get_tensor().set_names({"INPUT"});
+
+  Constants constants(options.seed);
+  ov::Output<ov::Node> output;
+  if (options.type == "mlp") {
+    output = Mlp(options, constants, input);
+  } else if (options.type == "conv") {
+    output = Conv(options, constants, input);
+  } else {
+    output = Transformer(options, constants, input);
+  }
+  output.get_tensor().set_names({"OUTPUT"});
+  auto result = std::make_shared<Result>(output);
+  result->set_friendly_name("OUTPUT");
+
+  return std::make_shared<ov::Model>(
+      ov::ResultVector{result}, ov::ParameterVector{input}, options.model);
+}
+
+// The dims of 'shape' in the model configuration, without the batch dim
+// if the model batches.
+std::vector<int64_t>
+ConfigDims(const Options& options, const ov::PartialShape& shape)
+{
+  std::vector<int64_t> dims;
+  for (size_t i = (options.max_batch_size > 0) ? 1 : 0; i < shape.size();
+       i++) {
+    dims.push_back(shape[i].is_static() ? shape[i].get_length() : -1);
+  }
+  return dims;
+}
+
+std::string
+JoinDims(const std::vector<int64_t>& dims)
+{
+  std::string str;
+  for (const auto dim : dims) {
+    str += (str.empty() ? "" : ", ") + std::to_string(dim);
+  }
+  return str;
+}
+
+void
+MakeDir(const std::string& path)
+{
+  if ((mkdir(path.c_str(), 0755) != 0) && (errno != EEXIST)) {
+    throw std::runtime_error(
+        "unable to create the directory '" + path + "': " + strerror(errno));
+  }
+}
+
+void
+WriteFile(const std::string& path, const std::string& content)
+{
+  std::ofstream file(path);
+  file << content;
+  if (!file) {
+    throw std::runtime_error("failed to write '" + path + "'");
+  }
+}
+
+// Writes the model and its configuration, as protobuf text for Triton
+// and as JSON for the benchmark, into the model repository.
+void
+WriteModelRepository(
+    const Options& options, const std::shared_ptr<ov::Model>& model)
+{
+  const std::string model_dir = options.repository + "/" + options.model;
+  const std::string version_dir =
+      model_dir + "/" + std::to_string(options.version);
+  MakeDir(options.repository);
+  MakeDir(model_dir);
+  MakeDir(version_dir);
+  ov::pass::Serialize(version_dir + "/model.xml", version_dir + "/model.bin")
+      .run_on_model(model);
+
+  const std::string input_dims =
+      JoinDims(ConfigDims(options, model->input(0).get_partial_shape()));
+  const std::string output_dims =
+      JoinDims(ConfigDims(options, model->output(0).get_partial_shape()));
+  const std::string max_batch_size = std::to_string(options.max_batch_size);
+
+  std::stringstream pbtxt;
+  pbtxt << "name: \"" << options.model << "\"\n"
+        << "backend: \"openvino\"\n"
+        << "max_batch_size: " << max_batch_size << "\n"
+        << "input [\n  {\n    name: \"INPUT\"\n    data_type: TYPE_FP32\n"
+        << "    dims: [ " << input_dims << " ]\n  }\n]\n"
+        << "output [\n  {\n    name: \"OUTPUT\"\n    data_type: TYPE_FP32\n"
+        << "    dims: [ " << output_dims << " ]\n  }\n]\n"
+        << "instance_group [\n  {\n    kind: KIND_CPU\n  }\n]\n";
+  WriteFile(model_dir + "/config.pbtxt", pbtxt.str());
+
+  std::stringstream json;
+  json << "{\"name\": \"" << options.model << "\", \"backend\": \"openvino\", "
+       << "\"max_batch_size\": " << max_batch_size << ", "
+       << "\"input\": [{\"name\": \"INPUT\", \"data_type\": \"TYPE_FP32\", "
+       << "\"dims\": [" << input_dims << "]}], "
+       << "\"output\": [{\"name\": \"OUTPUT\", \"data_type\": \"TYPE_FP32\", "
+       << "\"dims\": [" << output_dims << "]}], "
+       << "\"instance_group\": [{\"kind\": \"KIND_CPU\"}]}\n";
+  WriteFile(model_dir + "/config.json", json.str());
+}
+
+// Returns whether 'arg' is '<key>=<value>', and the value if so.
+bool
+ArgValue(const char* arg, const char* key, std::string* value)
+{
+  const size_t key_len = strlen(key);
+  if ((strncmp(arg, key, key_len) != 0) || (arg[key_len] != '=')) {
+    return false;
+  }
+  *value = arg + key_len + 1;
+  return true;
+}
+
+// Parses the value 'str' of 'option' as a non-negative number no larger
+// than 'max'.
+uint64_t
+ParseNumber(const char* option, const std::string& str, const uint64_t max)
+{
+  if (!str.empty() &&
+      (str.find_first_not_of("0123456789") == std::string::npos)) {
+    try {
+      const uint64_t number = std::stoull(str);
+      if (number <= max) {
+        return number;
+      }
+    }
+    catch (const std::out_of_range&) {
+    }
+  }
+  throw std::invalid_argument(
+      std::string("expected ") + option + " to be a number up to " +
+      std::to_string(max) + ", got '" + str + "'");
+}
+
+void
+ParseOptions(int argc, char** argv, Options* options)
+{
+  // The numeric options, by name.
+  std::map<std::string, size_t*> sizes{
+      {"--layers", &options->layers},
+      {"--input-width", &options->input_width},
+      {"--width", &options->width},
+      {"--output-width", &options->output_width},
+      {"--channels", &options->channels},
+      {"--height", &options->height},
+      {"--image-width", &options->image_width},
+      {"--sequence", &options->sequence},
+      {"--hidden", &options->hidden},
+      {"--heads", &options->heads}};
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    std::string value;
+    if (ArgValue(arg, "--model-repository", &value)) {
+      options->repository = value;
+    } else if (ArgValue(arg, "--model", &value)) {
+      options->model = value;
+    } else if (ArgValue(arg, "--type", &value)) {
+      options->type = value;
+    } else if (ArgValue(arg, "--version", &value)) {
+      options->version = ParseNumber("--version", value, UINT64_MAX);
+    } else if (ArgValue(arg, "--max-batch-size", &value)) {
+      options->max_batch_size =
+          ParseNumber("--max-batch-size", value, INT32_MAX);
+    } else if (ArgValue(arg, "--seed", &value)) {
+      options->seed = ParseNumber("--seed", value, UINT32_MAX);
+    } else if (strcmp(arg, "--static-batch") == 0) {
+      options->static_batch = true;
+    } else if (strcmp(arg, "--dynamic-dims") == 0) {
+      options->dynamic_dims = true;
+    } else {
+      const char* eq = strchr(arg, '=');
+      auto it = sizes.find(
+          (eq == nullptr) ? std::string(arg) : std::string(arg, eq - arg));
+      if ((eq == nullptr) || (it == sizes.end())) {
+        throw std::invalid_argument(
+            std::string("unexpected argument '") + arg + "'");
+      }
+      *it->second = ParseNumber(it->first.c_str(), eq + 1, SIZE_MAX);
+    }
+  }
+  if (options->repository.empty() || options->model.empty() ||
+      options->type.empty()) {
+    throw std::invalid_argument(
+        "--model-repository, --model and --type are required");
+  }
+  if (options->layers == 0) {
+    throw std::invalid_argument("--layers must be at least 1");
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  try {
+    Options options;
+    ParseOptions(argc, argv, &options);
+    WriteModelRepository(options, CreateModel(options));
+  }
+  catch (const std::exception& error) {
+    fprintf(stderr, "error: %s\n", error.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,309 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Replays the executions captured in a trace by the backend (see
+// CAPTURE_PATH) on the model, through the mock of the Triton API, with
+// the requests and the arrival pattern of the trace.
+//
+// openvino_trace_replay --model-repository=<dir> --trace=<file>
+//     [--model=<name>] [--version=<version>] [--config=<json>]
+//     [--param=<key>=<value>]... [--speed=1.0] [--per-execution]
+//     [-v|-vv]
+//
+// The model and version default to those of the trace. The executions
+// start at the offsets they started at in the trace, divided by
+// '--speed', or as soon as the previous one is done if later. The inputs
+// whose data wasn't captured are synthesized. The latencies of the
+// executions are reported next to those recorded in the trace.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend_harness.h"
+#include "openvino_trace.h"
+#include "triton/backend/backend_common.h"
+
+namespace triton { namespace backend { namespace openvino { namespace mock {
+
+namespace {
+
+struct Options {
+  std::string repository;
+  std::string trace_path;
+  std::string model;
+  uint64_t version = 0;
+  std::string config_path;
+  std::vector<std::pair<std::string, std::string>> parameters;
+  double speed = 1.0;
+  bool per_execution = false;
+  TRITONSERVER_LogLevel log_level = TRITONSERVER_LOG_WARN;
+};
+
+TRITONSERVER_Error*
+ParseOptions(int argc, char** argv, Options* options)
+{
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    std::string value;
+    if (ArgValue(arg, "--model-repository", &value)) {
+      options->repository = value;
+    } else if (ArgValue(arg, "--trace", &value)) {
+      options->trace_path = value;
+    } else if (ArgValue(arg, "--model", &value)) {
+      options->model = value;
+    } else if (ArgValue(arg, "--version", &value)) {
+      RETURN_IF_ERROR(ParseNumber("--version", value, &options->version));
+    } else if (ArgValue(arg, "--config", &value)) {
+      options->config_path = value;
+    } else if (ArgValue(arg, "--param", &value)) {
+      const size_t pos = value.find('=');
+      if (pos == std::string::npos) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            ("expected --param=<key>=<value>, got '" + value + "'").c_str());
+      }
+      options->parameters.emplace_back(
+          value.substr(0, pos), value.substr(pos + 1));
+    } else if (ArgValue(arg, "--speed", &value)) {
+      char* end = nullptr;
+      options->speed = strtod(value.c_str(), &end);
+      if (value.empty() || (*end != '\0')) {
+        return TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_INVALID_ARG,
+            ("expected --speed to be a number, got '" + value + "'").c_str());
+      }
+    } else if (strcmp(arg, "--per-execution") == 0) {
+      options->per_execution = true;
+    } else if (strcmp(arg, "-v") == 0) {
+      options->log_level = TRITONSERVER_LOG_INFO;
+    } else if (strcmp(arg, "-vv") == 0) {
+      options->log_level = TRITONSERVER_LOG_VERBOSE;
+    } else {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("unexpected argument '") + arg + "'").c_str());
+    }
+  }
+  if (options->repository.empty() || options->trace_path.empty()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "--model-repository and --trace are required");
+  }
+  if (options->speed <= 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG, "--speed must be above 0");
+  }
+  return nullptr;
+}
+
+// Reads all the executions of the trace, before the model is loaded,
+// which may capture again.
+TRITONSERVER_Error*
+ReadTrace(Options* options, std::vector<TraceExecution>* executions)
+{
+  std::unique_ptr<TraceReader> reader;
+  RETURN_IF_ERROR(TraceReader::Create(options->trace_path, &reader));
+  if (options->model.empty()) {
+    options->model = reader->ModelName();
+  }
+  if (options->version == 0) {
+    options->version = reader->ModelVersion();
+  }
+
+  while (true) {
+    TraceExecution execution;
+    bool done;
+    RETURN_IF_ERROR(reader->Read(&execution, &done));
+    if (done) {
+      break;
+    }
+    executions->push_back(std::move(execution));
+  }
+  if (executions->empty()) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        ("the trace '" + options->trace_path + "' has no executions")
+            .c_str());
+  }
+  return nullptr;
+}
+
+void
+ReportLatencies(const char* label, std::vector<uint64_t> latencies_ns)
+{
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto percentile = [&latencies_ns](const size_t percent) {
+    size_t idx = (latencies_ns.size() * percent + 99) / 100;
+    return latencies_ns[std::max<size_t>(idx, 1) - 1] / 1e3;
+  };
+  printf(
+      "%s latency (us): p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", label,
+      percentile(50), percentile(90), percentile(99),
+      latencies_ns.back() / 1e3);
+}
+
+TRITONSERVER_Error*
+Run(Options* options)
+{
+  SetLogLevel(options->log_level);
+  std::vector<TraceExecution> executions;
+  RETURN_IF_ERROR(ReadTrace(options, &executions));
+
+  Recorder recorder;
+  Harness harness;
+  RETURN_IF_ERROR(harness.Load(
+      options->repository, options->model, options->version,
+      options->config_path, options->parameters, &recorder));
+  std::vector<ModelInput> inputs;
+  std::vector<std::string> outputs;
+  int64_t max_batch_size;
+  RETURN_IF_ERROR(
+      harness.ModelConfig({}, &inputs, &outputs, &max_batch_size));
+
+  // The synthesized data of the inputs whose data wasn't captured, by
+  // name and shape.
+  std::map<std::pair<std::string, std::vector<int64_t>>, std::vector<char>>
+      input_data;
+  std::vector<std::unique_ptr<Request>> requests;
+  // The requests of each execution, and how late it started.
+  std::vector<std::pair<size_t, size_t>> exec_requests_range;
+  std::vector<uint64_t> start_lags_ns;
+  const uint64_t trace_start_ns = executions.front().start_ns;
+  const uint64_t replay_start_ns = Now();
+  for (const auto& execution : executions) {
+    std::vector<TRITONBACKEND_Request*> exec_requests;
+    const size_t first_request = requests.size();
+    for (const auto& trace_request : execution.requests) {
+      std::unique_ptr<Request> request(new Request());
+      request->observer = &recorder;
+      request->id = std::to_string(requests.size());
+      request->requested_outputs = trace_request.requested_outputs.empty()
+                                       ? outputs
+                                       : trace_request.requested_outputs;
+      for (const auto& trace_input : trace_request.inputs) {
+        Input input;
+        input.name = trace_input.name;
+        input.datatype = trace_input.datatype;
+        input.shape = trace_input.shape;
+        const std::vector<char>* data = &trace_input.data;
+        if (data->empty()) {
+          auto& synthesized = input_data[{input.name, input.shape}];
+          if (synthesized.empty()) {
+            FillInput(
+                input.datatype, GetElementCount(input.shape), &synthesized);
+          }
+          data = &synthesized;
+        }
+        input.buffer = data->data();
+        input.byte_size = data->size();
+        request->inputs.push_back(input);
+      }
+      exec_requests.push_back(Handle<TRITONBACKEND_Request>(request.get()));
+      requests.push_back(std::move(request));
+    }
+    exec_requests_range.emplace_back(first_request, requests.size());
+
+    const uint64_t target_ns =
+        replay_start_ns +
+        (uint64_t)((execution.start_ns - trace_start_ns) / options->speed);
+    uint64_t now_ns = Now();
+    if (now_ns < target_ns) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(target_ns - now_ns));
+      now_ns = Now();
+    }
+    start_lags_ns.push_back(now_ns - target_ns);
+    for (auto exec_request : exec_requests) {
+      Object<Request>(exec_request)->arrival_ns = now_ns;
+    }
+    RETURN_IF_ERROR(harness.Execute(&exec_requests));
+  }
+  recorder.WaitForReleased(requests.size());
+  RETURN_IF_ERROR(harness.Unload());
+
+  std::vector<uint64_t> recorded_ns;
+  std::vector<uint64_t> replayed_ns;
+  for (size_t e = 0; e < executions.size(); e++) {
+    recorded_ns.push_back(executions[e].end_ns - executions[e].start_ns);
+    uint64_t latency_ns = 0;
+    for (size_t r = exec_requests_range[e].first;
+         r < exec_requests_range[e].second; r++) {
+      latency_ns = std::max(
+          latency_ns, requests[r]->response_ns - requests[r]->arrival_ns);
+    }
+    replayed_ns.push_back(latency_ns);
+    if (options->per_execution) {
+      printf(
+          "execution %zu: %zu requests, recorded %.1f us, replayed %.1f us, "
+          "started %.1f us late\n",
+          e, executions[e].requests.size(), recorded_ns.back() / 1e3,
+          replayed_ns.back() / 1e3, start_lags_ns[e] / 1e3);
+    }
+  }
+
+  printf("executions: %zu\n", executions.size());
+  printf("requests: %zu\n", requests.size());
+  printf("failed requests: %zu\n", recorder.FailedCount());
+  if (recorder.FailedCount() > 0) {
+    printf("first error: %s\n", recorder.FirstError().c_str());
+  }
+  ReportLatencies("recorded", recorded_ns);
+  ReportLatencies("replayed", replayed_ns);
+  printf(
+      "max start lag: %.1f us\n",
+      *std::max_element(start_lags_ns.begin(), start_lags_ns.end()) / 1e3);
+  return nullptr;
+}
+
+}  // namespace
+
+}}}}  // namespace triton::backend::openvino::mock
+
+int
+main(int argc, char** argv)
+{
+  using namespace triton::backend::openvino::mock;
+
+  Options options;
+  TRITONSERVER_Error* err = ParseOptions(argc, argv, &options);
+  if (err == nullptr) {
+    err = Run(&options);
+  }
+  if (err != nullptr) {
+    fprintf(stderr, "error: %s\n", TRITONSERVER_ErrorMessage(err));
+    TRITONSERVER_ErrorDelete(err);
+    return 1;
+  }
+  return 0;
+}
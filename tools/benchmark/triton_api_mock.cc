@@ -0,0 +1,1093 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "triton_api_mock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace triton { namespace backend { namespace openvino { namespace mock {
+
+namespace {
+
+std::atomic<int> log_level(TRITONSERVER_LOG_WARN);
+std::mutex log_mu;
+// The depth of the calls served by the mock on each thread, constant
+// initialized so that reading it never allocates.
+thread_local int server_depth = 0;
+
+TRITONSERVER_Error*
+NewError(TRITONSERVER_Error_Code code, const std::string& message)
+{
+  ServerScope scope;
+  return Handle<TRITONSERVER_Error>(new Error{code, message});
+}
+
+// The severity of 'level', lower is more severe.
+int
+LogSeverity(TRITONSERVER_LogLevel level)
+{
+  switch (level) {
+    case TRITONSERVER_LOG_ERROR:
+      return 0;
+    case TRITONSERVER_LOG_WARN:
+      return 1;
+    case TRITONSERVER_LOG_INFO:
+      return 2;
+    default:
+      return 3;
+  }
+}
+
+}  // namespace
+
+void
+SetLogLevel(TRITONSERVER_LogLevel level)
+{
+  log_level = level;
+}
+
+ServerScope::ServerScope()
+{
+  server_depth++;
+}
+
+ServerScope::~ServerScope()
+{
+  server_depth--;
+}
+
+bool
+ServerScope::Active()
+{
+  return server_depth > 0;
+}
+
+}}}}  // namespace triton::backend::openvino::mock
+
+using namespace triton::backend::openvino::mock;
+
+extern "C" {
+
+//
+// TRITONSERVER_Error
+//
+TRITONSERVER_Error*
+TRITONSERVER_ErrorNew(TRITONSERVER_Error_Code code, const char* msg)
+{
+  ServerScope scope;
+  return NewError(code, msg);
+}
+
+void
+TRITONSERVER_ErrorDelete(TRITONSERVER_Error* error)
+{
+  delete Object<Error>(error);
+}
+
+TRITONSERVER_Error_Code
+TRITONSERVER_ErrorCode(TRITONSERVER_Error* error)
+{
+  return Object<Error>(error)->code;
+}
+
+const char*
+TRITONSERVER_ErrorCodeString(TRITONSERVER_Error* error)
+{
+  switch (Object<Error>(error)->code) {
+    case TRITONSERVER_ERROR_INTERNAL:
+      return "Internal";
+    case TRITONSERVER_ERROR_NOT_FOUND:
+      return "Not found";
+    case TRITONSERVER_ERROR_INVALID_ARG:
+      return "Invalid argument";
+    case TRITONSERVER_ERROR_UNAVAILABLE:
+      return "Unavailable";
+    case TRITONSERVER_ERROR_UNSUPPORTED:
+      return "Unsupported";
+    case TRITONSERVER_ERROR_ALREADY_EXISTS:
+      return "Already exists";
+    default:
+      return "Unknown";
+  }
+}
+
+const char*
+TRITONSERVER_ErrorMessage(TRITONSERVER_Error* error)
+{
+  return Object<Error>(error)->message.c_str();
+}
+
+//
+// Data, memory and instance kinds
+//
+const char*
+TRITONSERVER_DataTypeString(TRITONSERVER_DataType datatype)
+{
+  switch (datatype) {
+    case TRITONSERVER_TYPE_BOOL:
+      return "BOOL";
+    case TRITONSERVER_TYPE_UINT8:
+      return "UINT8";
+    case TRITONSERVER_TYPE_UINT16:
+      return "UINT16";
+    case TRITONSERVER_TYPE_UINT32:
+      return "UINT32";
+    case TRITONSERVER_TYPE_UINT64:
+      return "UINT64";
+    case TRITONSERVER_TYPE_INT8:
+      return "INT8";
+    case TRITONSERVER_TYPE_INT16:
+      return "INT16";
+    case TRITONSERVER_TYPE_INT32:
+      return "INT32";
+    case TRITONSERVER_TYPE_INT64:
+      return "INT64";
+    case TRITONSERVER_TYPE_FP16:
+      return "FP16";
+    case TRITONSERVER_TYPE_FP32:
+      return "FP32";
+    case TRITONSERVER_TYPE_FP64:
+      return "FP64";
+    case TRITONSERVER_TYPE_BYTES:
+      return "BYTES";
+    default:
+      return "<invalid>";
+  }
+}
+
+TRITONSERVER_DataType
+TRITONSERVER_StringToDataType(const char* dtype)
+{
+  static const TRITONSERVER_DataType datatypes[] = {
+      TRITONSERVER_TYPE_BOOL,  TRITONSERVER_TYPE_UINT8,
+      TRITONSERVER_TYPE_UINT16, TRITONSERVER_TYPE_UINT32,
+      TRITONSERVER_TYPE_UINT64, TRITONSERVER_TYPE_INT8,
+      TRITONSERVER_TYPE_INT16, TRITONSERVER_TYPE_INT32,
+      TRITONSERVER_TYPE_INT64, TRITONSERVER_TYPE_FP16,
+      TRITONSERVER_TYPE_FP32,  TRITONSERVER_TYPE_FP64,
+      TRITONSERVER_TYPE_BYTES};
+  for (const auto datatype : datatypes) {
+    if (strcmp(dtype, TRITONSERVER_DataTypeString(datatype)) == 0) {
+      return datatype;
+    }
+  }
+  return TRITONSERVER_TYPE_INVALID;
+}
+
+uint32_t
+TRITONSERVER_DataTypeByteSize(TRITONSERVER_DataType datatype)
+{
+  switch (datatype) {
+    case TRITONSERVER_TYPE_BOOL:
+    case TRITONSERVER_TYPE_UINT8:
+    case TRITONSERVER_TYPE_INT8:
+      return 1;
+    case TRITONSERVER_TYPE_UINT16:
+    case TRITONSERVER_TYPE_INT16:
+    case TRITONSERVER_TYPE_FP16:
+      return 2;
+    case TRITONSERVER_TYPE_UINT32:
+    case TRITONSERVER_TYPE_INT32:
+    case TRITONSERVER_TYPE_FP32:
+      return 4;
+    case TRITONSERVER_TYPE_UINT64:
+    case TRITONSERVER_TYPE_INT64:
+    case TRITONSERVER_TYPE_FP64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+const char*
+TRITONSERVER_MemoryTypeString(TRITONSERVER_MemoryType memtype)
+{
+  switch (memtype) {
+    case TRITONSERVER_MEMORY_CPU:
+      return "CPU";
+    case TRITONSERVER_MEMORY_CPU_PINNED:
+      return "CPU_PINNED";
+    case TRITONSERVER_MEMORY_GPU:
+      return "GPU";
+    default:
+      return "<invalid>";
+  }
+}
+
+const char*
+TRITONSERVER_InstanceGroupKindString(TRITONSERVER_InstanceGroupKind kind)
+{
+  switch (kind) {
+    case TRITONSERVER_INSTANCEGROUPKIND_AUTO:
+      return "AUTO";
+    case TRITONSERVER_INSTANCEGROUPKIND_CPU:
+      return "CPU";
+    case TRITONSERVER_INSTANCEGROUPKIND_GPU:
+      return "GPU";
+    case TRITONSERVER_INSTANCEGROUPKIND_MODEL:
+      return "MODEL";
+    default:
+      return "<invalid>";
+  }
+}
+
+//
+// Logging
+//
+bool
+TRITONSERVER_LogIsEnabled(TRITONSERVER_LogLevel level)
+{
+  return LogSeverity(level) <=
+         LogSeverity(static_cast<TRITONSERVER_LogLevel>(log_level.load()));
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_LogMessage(
+    TRITONSERVER_LogLevel level, const char* filename, const int line,
+    const char* msg)
+{
+  ServerScope scope;
+  if (TRITONSERVER_LogIsEnabled(level)) {
+    static const char levels[] = {'E', 'W', 'I', 'V'};
+    std::lock_guard<std::mutex> lock(log_mu);
+    fprintf(
+        stderr, "%c %s:%d] %s\n", levels[LogSeverity(level)], filename, line,
+        msg);
+  }
+  return nullptr;
+}
+
+//
+// TRITONSERVER_Message
+//
+TRITONSERVER_Error*
+TRITONSERVER_MessageNewFromSerializedJson(
+    TRITONSERVER_Message** message, const char* base, size_t byte_size)
+{
+  ServerScope scope;
+  *message =
+      Handle<TRITONSERVER_Message>(new Message{std::string(base, byte_size)});
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_MessageDelete(TRITONSERVER_Message* message)
+{
+  delete Object<Message>(message);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_MessageSerializeToJson(
+    TRITONSERVER_Message* message, const char** base, size_t* byte_size)
+{
+  *base = Object<Message>(message)->json.c_str();
+  *byte_size = Object<Message>(message)->json.size();
+  return nullptr;
+}
+
+//
+// TRITONSERVER_Parameter
+//
+TRITONSERVER_Parameter*
+TRITONSERVER_ParameterNew(
+    const char* name, const TRITONSERVER_ParameterType type, const void* value)
+{
+  ServerScope scope;
+  std::string str;
+  switch (type) {
+    case TRITONSERVER_PARAMETER_STRING:
+      str = reinterpret_cast<const char*>(value);
+      break;
+    case TRITONSERVER_PARAMETER_INT:
+      str = std::to_string(*reinterpret_cast<const int64_t*>(value));
+      break;
+    case TRITONSERVER_PARAMETER_BOOL:
+      str = *reinterpret_cast<const bool*>(value) ? "true" : "false";
+      break;
+    default:
+      return nullptr;
+  }
+  return Handle<TRITONSERVER_Parameter>(new Parameter{name, type, str});
+}
+
+void
+TRITONSERVER_ParameterDelete(TRITONSERVER_Parameter* parameter)
+{
+  delete Object<Parameter>(parameter);
+}
+
+//
+// Metrics, which the mock doesn't collect.
+//
+TRITONSERVER_Error*
+TRITONSERVER_MetricFamilyNew(
+    TRITONSERVER_MetricFamily** family, const TRITONSERVER_MetricKind kind,
+    const char* name, const char* description)
+{
+  return NewError(
+      TRITONSERVER_ERROR_UNSUPPORTED, "metrics are not supported by the mock");
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_MetricFamilyDelete(TRITONSERVER_MetricFamily* family)
+{
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_MetricNew(
+    TRITONSERVER_Metric** metric, TRITONSERVER_MetricFamily* family,
+    const TRITONSERVER_Parameter** labels, const uint64_t label_count)
+{
+  return NewError(
+      TRITONSERVER_ERROR_UNSUPPORTED, "metrics are not supported by the mock");
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_MetricDelete(TRITONSERVER_Metric* metric)
+{
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_MetricIncrement(TRITONSERVER_Metric* metric, double value)
+{
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_MetricSet(TRITONSERVER_Metric* metric, double value)
+{
+  return nullptr;
+}
+
+//
+// TRITONSERVER_BufferAttributes
+//
+TRITONSERVER_Error*
+TRITONSERVER_BufferAttributesMemoryType(
+    TRITONSERVER_BufferAttributes* buffer_attributes,
+    TRITONSERVER_MemoryType* memory_type)
+{
+  *memory_type = Object<BufferAttributes>(buffer_attributes)->memory_type;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_BufferAttributesMemoryTypeId(
+    TRITONSERVER_BufferAttributes* buffer_attributes, int64_t* memory_type_id)
+{
+  *memory_type_id = Object<BufferAttributes>(buffer_attributes)->memory_type_id;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_BufferAttributesByteSize(
+    TRITONSERVER_BufferAttributes* buffer_attributes, size_t* byte_size)
+{
+  *byte_size = Object<BufferAttributes>(buffer_attributes)->byte_size;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_BufferAttributesCudaIpcHandle(
+    TRITONSERVER_BufferAttributes* buffer_attributes, void** cuda_ipc_handle)
+{
+  *cuda_ipc_handle = nullptr;
+  return nullptr;
+}
+
+//
+// TRITONBACKEND_Backend
+//
+TRITONSERVER_Error*
+TRITONBACKEND_ApiVersion(uint32_t* major, uint32_t* minor)
+{
+  *major = TRITONBACKEND_API_VERSION_MAJOR;
+  *minor = TRITONBACKEND_API_VERSION_MINOR;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendName(TRITONBACKEND_Backend* backend, const char** name)
+{
+  *name = Object<Backend>(backend)->name.c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendConfig(
+    TRITONBACKEND_Backend* backend, TRITONSERVER_Message** backend_config)
+{
+  *backend_config =
+      Handle<TRITONSERVER_Message>(&Object<Backend>(backend)->config);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendExecutionPolicy(
+    TRITONBACKEND_Backend* backend, TRITONBACKEND_ExecutionPolicy* policy)
+{
+  *policy = TRITONBACKEND_EXECUTION_BLOCKING;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendSetExecutionPolicy(
+    TRITONBACKEND_Backend* backend, TRITONBACKEND_ExecutionPolicy policy)
+{
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendArtifacts(
+    TRITONBACKEND_Backend* backend, TRITONBACKEND_ArtifactType* artifact_type,
+    const char** location)
+{
+  *artifact_type = TRITONBACKEND_ARTIFACT_FILESYSTEM;
+  *location = "";
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendMemoryManager(
+    TRITONBACKEND_Backend* backend, TRITONBACKEND_MemoryManager** manager)
+{
+  // The memory manager has no state, any non-null handle does.
+  *manager = Handle<TRITONBACKEND_MemoryManager>(backend);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendState(TRITONBACKEND_Backend* backend, void** state)
+{
+  *state = Object<Backend>(backend)->state;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_BackendSetState(TRITONBACKEND_Backend* backend, void* state)
+{
+  Object<Backend>(backend)->state = state;
+  return nullptr;
+}
+
+//
+// TRITONBACKEND_MemoryManager, for CPU memory only.
+//
+TRITONSERVER_Error*
+TRITONBACKEND_MemoryManagerAllocate(
+    TRITONBACKEND_MemoryManager* manager, void** buffer,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    const uint64_t byte_size)
+{
+  ServerScope scope;
+  if (memory_type == TRITONSERVER_MEMORY_GPU) {
+    return NewError(
+        TRITONSERVER_ERROR_UNSUPPORTED,
+        "GPU memory is not supported by the mock");
+  }
+  *buffer = malloc(byte_size);
+  if (*buffer == nullptr) {
+    return NewError(
+        TRITONSERVER_ERROR_UNAVAILABLE,
+        "failed to allocate " + std::to_string(byte_size) + " bytes");
+  }
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_MemoryManagerFree(
+    TRITONBACKEND_MemoryManager* manager, void* buffer,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id)
+{
+  free(buffer);
+  return nullptr;
+}
+
+//
+// TRITONBACKEND_Model
+//
+TRITONSERVER_Error*
+TRITONBACKEND_ModelName(TRITONBACKEND_Model* model, const char** name)
+{
+  *name = Object<Model>(model)->name.c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelVersion(TRITONBACKEND_Model* model, uint64_t* version)
+{
+  *version = Object<Model>(model)->version;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelRepository(
+    TRITONBACKEND_Model* model, TRITONBACKEND_ArtifactType* artifact_type,
+    const char** location)
+{
+  *artifact_type = TRITONBACKEND_ARTIFACT_FILESYSTEM;
+  *location = Object<Model>(model)->path.c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelConfig(
+    TRITONBACKEND_Model* model, const uint32_t config_version,
+    TRITONSERVER_Message** model_config)
+{
+  ServerScope scope;
+  *model_config =
+      Handle<TRITONSERVER_Message>(new Message{Object<Model>(model)->config});
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelAutoCompleteConfig(
+    TRITONBACKEND_Model* model, bool* auto_complete_config)
+{
+  *auto_complete_config = Object<Model>(model)->auto_complete_config;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelSetConfig(
+    TRITONBACKEND_Model* model, const uint32_t config_version,
+    TRITONSERVER_Message* model_config)
+{
+  ServerScope scope;
+  Object<Model>(model)->config = Object<Message>(model_config)->json;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelServer(
+    TRITONBACKEND_Model* model, TRITONSERVER_Server** server)
+{
+  // There is no server, the backend only passes the handle around.
+  *server = Handle<TRITONSERVER_Server>(model);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelBackend(
+    TRITONBACKEND_Model* model, TRITONBACKEND_Backend** backend)
+{
+  *backend = Handle<TRITONBACKEND_Backend>(Object<Model>(model)->backend);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelState(TRITONBACKEND_Model* model, void** state)
+{
+  *state = Object<Model>(model)->state;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelSetState(TRITONBACKEND_Model* model, void* state)
+{
+  Object<Model>(model)->state = state;
+  return nullptr;
+}
+
+//
+// TRITONBACKEND_ModelInstance
+//
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceName(
+    TRITONBACKEND_ModelInstance* instance, const char** name)
+{
+  *name = Object<Instance>(instance)->name.c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceKind(
+    TRITONBACKEND_ModelInstance* instance, TRITONSERVER_InstanceGroupKind* kind)
+{
+  *kind = Object<Instance>(instance)->kind;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceDeviceId(
+    TRITONBACKEND_ModelInstance* instance, int32_t* device_id)
+{
+  *device_id = Object<Instance>(instance)->device_id;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceHostPolicy(
+    TRITONBACKEND_ModelInstance* instance, TRITONSERVER_Message** host_policy)
+{
+  *host_policy =
+      Handle<TRITONSERVER_Message>(&Object<Instance>(instance)->host_policy);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceIsPassive(
+    TRITONBACKEND_ModelInstance* instance, bool* is_passive)
+{
+  *is_passive = false;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceProfileCount(
+    TRITONBACKEND_ModelInstance* instance, uint32_t* count)
+{
+  *count = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceProfileName(
+    TRITONBACKEND_ModelInstance* instance, const uint32_t index,
+    const char** profile_name)
+{
+  return NewError(
+      TRITONSERVER_ERROR_INVALID_ARG, "the instance has no profiles");
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceSecondaryDeviceCount(
+    TRITONBACKEND_ModelInstance* instance, uint32_t* count)
+{
+  *count = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceSecondaryDeviceProperties(
+    TRITONBACKEND_ModelInstance* instance, uint32_t index, const char** kind,
+    int64_t* id)
+{
+  return NewError(
+      TRITONSERVER_ERROR_INVALID_ARG, "the instance has no secondary devices");
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceModel(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Model** model)
+{
+  *model = Handle<TRITONBACKEND_Model>(Object<Instance>(instance)->model);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceState(
+    TRITONBACKEND_ModelInstance* instance, void** state)
+{
+  *state = Object<Instance>(instance)->state;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceSetState(
+    TRITONBACKEND_ModelInstance* instance, void* state)
+{
+  Object<Instance>(instance)->state = state;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceReportStatistics(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request* request,
+    const bool success, const uint64_t exec_start_ns,
+    const uint64_t compute_start_ns, const uint64_t compute_end_ns,
+    const uint64_t exec_end_ns)
+{
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceReportBatchStatistics(
+    TRITONBACKEND_ModelInstance* instance, const uint64_t batch_size,
+    const uint64_t exec_start_ns, const uint64_t compute_start_ns,
+    const uint64_t compute_end_ns, const uint64_t exec_end_ns)
+{
+  ServerScope scope;
+  Object<Instance>(instance)->observer->BatchExecuted(
+      batch_size, exec_start_ns, compute_start_ns, compute_end_ns,
+      exec_end_ns);
+  return nullptr;
+}
+
+//
+// TRITONBACKEND_Request and TRITONBACKEND_Input
+//
+TRITONSERVER_Error*
+TRITONBACKEND_RequestId(TRITONBACKEND_Request* request, const char** id)
+{
+  *id = Object<Request>(request)->id.c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestCorrelationId(TRITONBACKEND_Request* request, uint64_t* id)
+{
+  *id = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestFlags(TRITONBACKEND_Request* request, uint32_t* flags)
+{
+  *flags = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestInputCount(
+    TRITONBACKEND_Request* request, uint32_t* count)
+{
+  *count = Object<Request>(request)->inputs.size();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestInputName(
+    TRITONBACKEND_Request* request, const uint32_t index,
+    const char** input_name)
+{
+  Request* req = Object<Request>(request);
+  if (index >= req->inputs.size()) {
+    return NewError(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "out of bounds index " + std::to_string(index) + " of the inputs");
+  }
+  *input_name = req->inputs[index].name.c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestInput(
+    TRITONBACKEND_Request* request, const char* name,
+    TRITONBACKEND_Input** input)
+{
+  for (auto& req_input : Object<Request>(request)->inputs) {
+    if (req_input.name == name) {
+      *input = Handle<TRITONBACKEND_Input>(&req_input);
+      return nullptr;
+    }
+  }
+  return NewError(
+      TRITONSERVER_ERROR_INVALID_ARG,
+      std::string("the request has no input '") + name + "'");
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestInputByIndex(
+    TRITONBACKEND_Request* request, const uint32_t index,
+    TRITONBACKEND_Input** input)
+{
+  Request* req = Object<Request>(request);
+  if (index >= req->inputs.size()) {
+    return NewError(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "out of bounds index " + std::to_string(index) + " of the inputs");
+  }
+  *input = Handle<TRITONBACKEND_Input>(&req->inputs[index]);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestOutputCount(
+    TRITONBACKEND_Request* request, uint32_t* count)
+{
+  *count = Object<Request>(request)->requested_outputs.size();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestOutputName(
+    TRITONBACKEND_Request* request, const uint32_t index,
+    const char** output_name)
+{
+  Request* req = Object<Request>(request);
+  if (index >= req->requested_outputs.size()) {
+    return NewError(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "out of bounds index " + std::to_string(index) + " of the outputs");
+  }
+  *output_name = req->requested_outputs[index].c_str();
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_RequestRelease(
+    TRITONBACKEND_Request* request, uint32_t release_flags)
+{
+  ServerScope scope;
+  Request* req = Object<Request>(request);
+  req->observer->RequestReleased(req);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_InputProperties(
+    TRITONBACKEND_Input* input, const char** name,
+    TRITONSERVER_DataType* datatype, const int64_t** shape,
+    uint32_t* dims_count, uint64_t* byte_size, uint32_t* buffer_count)
+{
+  Input* in = Object<Input>(input);
+  if (name != nullptr) {
+    *name = in->name.c_str();
+  }
+  if (datatype != nullptr) {
+    *datatype = in->datatype;
+  }
+  if (shape != nullptr) {
+    *shape = in->shape.data();
+  }
+  if (dims_count != nullptr) {
+    *dims_count = in->shape.size();
+  }
+  if (byte_size != nullptr) {
+    *byte_size = in->byte_size;
+  }
+  if (buffer_count != nullptr) {
+    *buffer_count = 1;
+  }
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_InputPropertiesForHostPolicy(
+    TRITONBACKEND_Input* input, const char* host_policy_name,
+    const char** name, TRITONSERVER_DataType* datatype, const int64_t** shape,
+    uint32_t* dims_count, uint64_t* byte_size, uint32_t* buffer_count)
+{
+  return TRITONBACKEND_InputProperties(
+      input, name, datatype, shape, dims_count, byte_size, buffer_count);
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_InputBuffer(
+    TRITONBACKEND_Input* input, const uint32_t index, const void** buffer,
+    uint64_t* buffer_byte_size, TRITONSERVER_MemoryType* memory_type,
+    int64_t* memory_type_id)
+{
+  Input* in = Object<Input>(input);
+  if (index != 0) {
+    return NewError(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "out of bounds index " + std::to_string(index) + " of the buffers");
+  }
+  *buffer = in->buffer;
+  *buffer_byte_size = in->byte_size;
+  *memory_type = TRITONSERVER_MEMORY_CPU;
+  *memory_type_id = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_InputBufferForHostPolicy(
+    TRITONBACKEND_Input* input, const char* host_policy_name,
+    const uint32_t index, const void** buffer, uint64_t* buffer_byte_size,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
+{
+  return TRITONBACKEND_InputBuffer(
+      input, index, buffer, buffer_byte_size, memory_type, memory_type_id);
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_InputBufferAttributes(
+    TRITONBACKEND_Input* input, const uint32_t index, const void** buffer,
+    TRITONSERVER_BufferAttributes** buffer_attributes)
+{
+  Input* in = Object<Input>(input);
+  if (index != 0) {
+    return NewError(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "out of bounds index " + std::to_string(index) + " of the buffers");
+  }
+  in->attributes = {TRITONSERVER_MEMORY_CPU, 0, (size_t)in->byte_size};
+  *buffer = in->buffer;
+  *buffer_attributes = Handle<TRITONSERVER_BufferAttributes>(&in->attributes);
+  return nullptr;
+}
+
+//
+// TRITONBACKEND_Response and TRITONBACKEND_Output
+//
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseFactoryNew(
+    TRITONBACKEND_ResponseFactory** factory, TRITONBACKEND_Request* request)
+{
+  ServerScope scope;
+  *factory = Handle<TRITONBACKEND_ResponseFactory>(
+      new ResponseFactory{Object<Request>(request)});
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseFactoryDelete(TRITONBACKEND_ResponseFactory* factory)
+{
+  delete Object<ResponseFactory>(factory);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseFactorySendFlags(
+    TRITONBACKEND_ResponseFactory* factory, const uint32_t send_flags)
+{
+  ServerScope scope;
+  if ((send_flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) {
+    Request* request = Object<ResponseFactory>(factory)->request;
+    request->observer->ResponseSent(request, nullptr, true, nullptr);
+  }
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseNew(
+    TRITONBACKEND_Response** response, TRITONBACKEND_Request* request)
+{
+  ServerScope scope;
+  Response* res = new Response();
+  res->request = Object<Request>(request);
+  *response = Handle<TRITONBACKEND_Response>(res);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseNewFromFactory(
+    TRITONBACKEND_Response** response, TRITONBACKEND_ResponseFactory* factory)
+{
+  return TRITONBACKEND_ResponseNew(
+      response, Handle<TRITONBACKEND_Request>(
+                    Object<ResponseFactory>(factory)->request));
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseDelete(TRITONBACKEND_Response* response)
+{
+  delete Object<Response>(response);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseSetStringParameter(
+    TRITONBACKEND_Response* response, const char* name, const char* value)
+{
+  ServerScope scope;
+  Object<Response>(response)->parameters.push_back(
+      Parameter{name, TRITONSERVER_PARAMETER_STRING, value});
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseSetIntParameter(
+    TRITONBACKEND_Response* response, const char* name, const int64_t value)
+{
+  ServerScope scope;
+  Object<Response>(response)->parameters.push_back(
+      Parameter{name, TRITONSERVER_PARAMETER_INT, std::to_string(value)});
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseSetBoolParameter(
+    TRITONBACKEND_Response* response, const char* name, const bool value)
+{
+  ServerScope scope;
+  Object<Response>(response)->parameters.push_back(Parameter{
+      name, TRITONSERVER_PARAMETER_BOOL, value ? "true" : "false"});
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseOutput(
+    TRITONBACKEND_Response* response, TRITONBACKEND_Output** output,
+    const char* name, const TRITONSERVER_DataType datatype,
+    const int64_t* shape, const uint32_t dims_count)
+{
+  ServerScope scope;
+  Response* res = Object<Response>(response);
+  res->outputs.emplace_back();
+  Output& out = res->outputs.back();
+  out.name = name;
+  out.datatype = datatype;
+  out.shape.assign(shape, shape + dims_count);
+  *output = Handle<TRITONBACKEND_Output>(&out);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_OutputBuffer(
+    TRITONBACKEND_Output* output, void** buffer,
+    const uint64_t buffer_byte_size, TRITONSERVER_MemoryType* memory_type,
+    int64_t* memory_type_id)
+{
+  ServerScope scope;
+  Output* out = Object<Output>(output);
+  out->buffer.resize(buffer_byte_size);
+  *buffer = out->buffer.data();
+  *memory_type = TRITONSERVER_MEMORY_CPU;
+  *memory_type_id = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_OutputBufferAttributes(
+    TRITONBACKEND_Output* output,
+    TRITONSERVER_BufferAttributes** buffer_attributes)
+{
+  Output* out = Object<Output>(output);
+  out->attributes = {TRITONSERVER_MEMORY_CPU, 0, out->buffer.size()};
+  *buffer_attributes =
+      Handle<TRITONSERVER_BufferAttributes>(&out->attributes);
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ResponseSend(
+    TRITONBACKEND_Response* response, const uint32_t send_flags,
+    TRITONSERVER_Error* error)
+{
+  // The response is owned by the server once sent, the error remains
+  // owned by the backend.
+  ServerScope scope;
+  Response* res = Object<Response>(response);
+  res->request->observer->ResponseSent(
+      res->request, res,
+      (send_flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0, error);
+  delete res;
+  return nullptr;
+}
+
+}  // extern "C"
@@ -0,0 +1,186 @@
+// Copyright 2021-2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "triton/core/tritonbackend.h"
+#include "triton/core/tritonserver.h"
+
+// The objects behind the opaque handles of the TRITONBACKEND and
+// TRITONSERVER APIs, for the tools that load the backend in place of a
+// Triton server. The mock implements the part of the APIs used by the
+// backend and the backend utilities, for CPU memory only, and hands the
+// handles out as pointers to these objects.
+
+namespace triton { namespace backend { namespace openvino { namespace mock {
+
+struct Response;
+struct Request;
+
+// Notified of the progress of the requests, possibly from the threads
+// of the backend and concurrently.
+class Observer {
+ public:
+  virtual ~Observer() = default;
+  // 'response' of 'request' is sent, the last one if 'final'. 'error'
+  // is null on success.
+  virtual void ResponseSent(
+      Request* request, Response* response, bool final,
+      TRITONSERVER_Error* error) = 0;
+  virtual void RequestReleased(Request* request) = 0;
+  // The times, in ns, of an execution of 'batch_size' rows.
+  virtual void BatchExecuted(
+      uint64_t batch_size, uint64_t exec_start_ns, uint64_t compute_start_ns,
+      uint64_t compute_end_ns, uint64_t exec_end_ns) = 0;
+};
+
+struct Error {
+  TRITONSERVER_Error_Code code;
+  std::string message;
+};
+
+struct Message {
+  std::string json;
+};
+
+struct Parameter {
+  std::string name;
+  TRITONSERVER_ParameterType type;
+  std::string value;
+};
+
+struct BufferAttributes {
+  TRITONSERVER_MemoryType memory_type;
+  int64_t memory_type_id;
+  size_t byte_size;
+};
+
+struct Backend {
+  std::string name;
+  Message config;
+  void* state = nullptr;
+};
+
+struct Model {
+  Backend* backend;
+  std::string name;
+  uint64_t version;
+  // The directory of the model in the model repository.
+  std::string path;
+  // The model configuration, as JSON.
+  std::string config;
+  bool auto_complete_config;
+  void* state = nullptr;
+};
+
+struct Instance {
+  Model* model;
+  std::string name;
+  TRITONSERVER_InstanceGroupKind kind = TRITONSERVER_INSTANCEGROUPKIND_CPU;
+  int32_t device_id = 0;
+  // The host policy of the instance, a single policy named after it.
+  Message host_policy;
+  Observer* observer;
+  void* state = nullptr;
+};
+
+// An input of a request, whose data is held by the caller.
+struct Input {
+  std::string name;
+  TRITONSERVER_DataType datatype;
+  std::vector<int64_t> shape;
+  const void* buffer;
+  uint64_t byte_size;
+  BufferAttributes attributes;
+};
+
+struct Request {
+  Observer* observer;
+  std::string id;
+  std::vector<Input> inputs;
+  std::vector<std::string> requested_outputs;
+  // For use by the caller.
+  uint64_t arrival_ns = 0;
+  uint64_t response_ns = 0;
+  uint64_t batch_size = 0;
+  bool measured = false;
+};
+
+struct Output {
+  std::string name;
+  TRITONSERVER_DataType datatype;
+  std::vector<int64_t> shape;
+  std::vector<char> buffer;
+  BufferAttributes attributes;
+};
+
+struct Response {
+  Request* request;
+  // Outputs are referred to by handle, a list doesn't move them.
+  std::list<Output> outputs;
+  std::vector<Parameter> parameters;
+};
+
+struct ResponseFactory {
+  Request* request;
+};
+
+// The verbosity of the log messages of the backend written to stderr,
+// errors and warnings only by default.
+void SetLogLevel(TRITONSERVER_LogLevel level);
+
+// Marks the calls the mock serves on behalf of the server, which
+// allocates the responses, their outputs and the errors, so that the
+// allocations counted on the thread leave them out.
+class ServerScope {
+ public:
+  ServerScope();
+  ~ServerScope();
+
+  // Whether the calling thread is in a call served by the mock.
+  static bool Active();
+};
+
+// Conversions of the objects to and from their handles.
+template <typename H, typename T>
+H*
+Handle(T* object)
+{
+  return reinterpret_cast<H*>(object);
+}
+template <typename T, typename H>
+T*
+Object(H* handle)
+{
+  return reinterpret_cast<T*>(handle);
+}
+
+}}}}  // namespace triton::backend::openvino::mock